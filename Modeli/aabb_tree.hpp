@@ -0,0 +1,434 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+
+#include <vector>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+const float AABB_TREE_MARGIN = 0.1f;         // fat boxes reach this far past the object, world units
+const float AABB_TREE_PREDICT = 2.0f;        // and this many moves ahead in the direction it moves
+const int   AABB_TREE_STACK = 256;           // query depth; an AVL tree of 2^100 objects fits
+
+struct AABB {
+    glm::vec3 lo = glm::vec3(FLT_MAX);
+    glm::vec3 hi = glm::vec3(-FLT_MAX);
+
+    AABB() = default;
+    AABB(const glm::vec3& lo, const glm::vec3& hi) : lo(lo), hi(hi) {}
+
+    bool contains(const AABB& b) const
+    {
+        return lo.x <= b.lo.x && lo.y <= b.lo.y && lo.z <= b.lo.z &&
+            hi.x >= b.hi.x && hi.y >= b.hi.y && hi.z >= b.hi.z;
+    }
+
+    bool overlaps(const AABB& b) const
+    {
+        return lo.x <= b.hi.x && lo.y <= b.hi.y && lo.z <= b.hi.z &&
+            hi.x >= b.lo.x && hi.y >= b.lo.y && hi.z >= b.lo.z;
+    }
+
+    // half the surface area: the SAH cost of the box
+    float area() const
+    {
+        const glm::vec3 e = hi - lo;
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+
+    glm::vec3 center() const
+    {
+        return (lo + hi) * 0.5f;
+    }
+
+    static AABB merge(const AABB& a, const AABB& b)
+    {
+        return AABB(glm::min(a.lo, b.lo), glm::max(a.hi, b.hi));
+    }
+};
+
+// Bounding volume tree over objects that come, go and move (after Box2D's b2DynamicTree).
+// every object is a leaf holding a fat box: its real box plus a margin, stretched ahead along
+// its motion. move() does nothing while the object stays inside its fat box, otherwise the
+// leaf is taken out and inserted again. inserting walks down to the sibling that grows the
+// tree's surface the least; on the way back up every node is rebalanced with AVL rotations,
+// so the height stays O(log n) however objects arrive and leave, and so do queries.
+// proxies (leaf ids) stay valid until remove(); the nodes live in one pool with a free list.
+class DynamicAABBTree {
+public:
+    // returns the proxy of a new object with box 'box'; user: anything, e.g. an object index
+    int insert(const AABB& box, int user)
+    {
+        const int proxy = allocate();
+        nodes[proxy].box = fatten(box, glm::vec3(0.0f));
+        nodes[proxy].user = user;
+        nodes[proxy].height = 0;
+        insertLeaf(proxy);
+        proxies++;
+        return proxy;
+    }
+
+    void remove(int proxy)
+    {
+        removeLeaf(proxy);
+        release(proxy);
+        proxies--;
+    }
+
+    // the object now has 'box', having moved by 'displacement' since the last call.
+    // true when its leaf had to be reinserted
+    bool move(int proxy, const AABB& box, const glm::vec3& displacement = glm::vec3(0.0f))
+    {
+        // still inside, and the fat box isn't much larger than a fresh one would be (e.g. a
+        // stretch left over from a fast move that has ended)
+        const AABB& fat = nodes[proxy].box;
+        const AABB fresh = fatten(box, displacement);
+        const AABB loose(fresh.lo - glm::vec3(4.0f * AABB_TREE_MARGIN), fresh.hi + glm::vec3(4.0f * AABB_TREE_MARGIN));
+        if (fat.contains(box) && loose.contains(fat)) return false;
+
+        removeLeaf(proxy);
+        nodes[proxy].box = fresh;
+        insertLeaf(proxy);
+        return true;
+    }
+
+    int user(int proxy) const
+    {
+        return nodes[proxy].user;
+    }
+
+    const AABB& fatBox(int proxy) const
+    {
+        return nodes[proxy].box;
+    }
+
+    int size() const
+    {
+        return proxies;
+    }
+
+    int height() const
+    {
+        return root < 0 ? 0 : nodes[root].height;
+    }
+
+    // summed area of the inner nodes over the root's: how much a query pays for the tree
+    float areaRatio() const
+    {
+        if (root < 0) return 0.0f;
+        float total = 0.0f;
+        for (const Node& n : nodes)
+            if (n.height > 0) total += n.box.area();
+        return total / std::max(nodes[root].box.area(), 1e-30f);
+    }
+
+    // fn(proxy) for every fat box overlapping 'box'; fn returns false to stop
+    template<class F>
+    void query(const AABB& box, F&& fn) const
+    {
+        walk([&](const AABB& b) { return b.overlaps(box); }, fn);
+    }
+
+    // fn(proxy) for every fat box within 'radius' of 'center'; fn returns false to stop
+    template<class F>
+    void querySphere(const glm::vec3& center, float radius, F&& fn) const
+    {
+        const float r2 = radius * radius;
+        walk([&](const AABB& b) {
+            const glm::vec3 nearest = glm::min(glm::max(center, b.lo), b.hi);
+            const glm::vec3 d = nearest - center;
+            return glm::dot(d, d) <= r2;
+        }, fn);
+    }
+
+    // fn(proxy) for every fat box not entirely behind one of the planes. a node entirely in
+    // front of all of them hands over its whole subtree without testing it further
+    template<class F>
+    void queryFrustum(const Frustum& f, F&& fn) const
+    {
+        if (root < 0) return;
+        struct Entry { int node; bool inside; };
+        Entry stack[AABB_TREE_STACK];
+        int top = 0;
+        stack[top++] = { root, false };
+        while (top > 0)
+        {
+            const Entry e = stack[--top];
+            const Node& n = nodes[e.node];
+            bool inside = e.inside;
+            if (!inside)
+            {
+                inside = true;
+                bool outside = false;
+                for (const glm::vec4& p : f.planes)
+                {
+                    // the corner farthest along the plane normal, and the one farthest against it
+                    const glm::vec3 pos(p.x >= 0.0f ? n.box.hi.x : n.box.lo.x, p.y >= 0.0f ? n.box.hi.y : n.box.lo.y, p.z >= 0.0f ? n.box.hi.z : n.box.lo.z);
+                    const glm::vec3 neg(p.x >= 0.0f ? n.box.lo.x : n.box.hi.x, p.y >= 0.0f ? n.box.lo.y : n.box.hi.y, p.z >= 0.0f ? n.box.lo.z : n.box.hi.z);
+                    if (p.x * pos.x + p.y * pos.y + p.z * pos.z + p.w < 0.0f) { outside = true; break; }
+                    if (p.x * neg.x + p.y * neg.y + p.z * neg.z + p.w < 0.0f) inside = false;
+                }
+                if (outside) continue;
+            }
+            if (n.height == 0)
+            {
+                fn(e.node);
+                continue;
+            }
+            if (top + 2 > AABB_TREE_STACK) continue;
+            stack[top++] = { n.child1, inside };
+            stack[top++] = { n.child2, inside };
+        }
+    }
+
+    // fn(proxy, tMax) for every fat box crossing o + t*d, 0 <= t <= tMax. fn may shorten tMax
+    // (closest hit so far): boxes beyond it are skipped from then on
+    template<class F>
+    void queryRay(const glm::vec3& o, const glm::vec3& d, float tMax, F&& fn) const
+    {
+        if (root < 0) return;
+        glm::vec3 inv;
+        for (int a = 0; a < 3; a++)
+        {
+            float c = d[a];
+            if (std::fabs(c) < 1e-30f) c = c < 0.0f ? -1e-30f : 1e-30f;
+            inv[a] = 1.0f / c;
+        }
+
+        // entry distance of a box, or FLT_MAX when the ray misses it before tMax
+        auto enter = [&](const AABB& box) {
+            const glm::vec3 t0 = (box.lo - o) * inv, t1 = (box.hi - o) * inv;
+            const glm::vec3 tn = glm::min(t0, t1), tf = glm::max(t0, t1);
+            const float in = std::max(std::max(tn.x, tn.y), std::max(tn.z, 0.0f));
+            const float out = std::min(std::min(tf.x, tf.y), std::min(tf.z, tMax));
+            return in <= out ? in : FLT_MAX;
+        };
+
+        // nearer child popped first, so fn can shorten tMax early
+        struct Entry { int node; float t; };
+        Entry stack[AABB_TREE_STACK];
+        int top = 0;
+        const float t = enter(nodes[root].box);
+        if (t != FLT_MAX) stack[top++] = { root, t };
+        while (top > 0)
+        {
+            const Entry e = stack[--top];
+            if (e.t > tMax) continue;
+            const Node& n = nodes[e.node];
+            if (n.height == 0)
+            {
+                fn(e.node, tMax);
+                continue;
+            }
+
+            Entry a = { n.child1, enter(nodes[n.child1].box) }, b = { n.child2, enter(nodes[n.child2].box) };
+            if (a.t < b.t) std::swap(a, b);   // b is the nearer one, pushed last
+            if (top + 2 > AABB_TREE_STACK) continue;
+            if (a.t != FLT_MAX) stack[top++] = a;
+            if (b.t != FLT_MAX) stack[top++] = b;
+        }
+    }
+
+private:
+    struct Node {
+        AABB box;
+        int parent = -1;       // next free node while on the free list
+        int child1 = -1, child2 = -1;
+        int height = -1;       // 0 = leaf, -1 = free
+        int user = -1;
+    };
+
+    std::vector<Node> nodes;
+    int root = -1;
+    int freeList = -1;
+    int proxies = 0;
+
+    static AABB fatten(const AABB& box, const glm::vec3& displacement)
+    {
+        AABB fat(box.lo - glm::vec3(AABB_TREE_MARGIN), box.hi + glm::vec3(AABB_TREE_MARGIN));
+        const glm::vec3 ahead = displacement * AABB_TREE_PREDICT;
+        fat.lo = glm::min(fat.lo, fat.lo + ahead);
+        fat.hi = glm::max(fat.hi, fat.hi + ahead);
+        return fat;
+    }
+
+    int allocate()
+    {
+        if (freeList < 0)
+        {
+            nodes.emplace_back();
+            return (int)nodes.size() - 1;
+        }
+        const int index = freeList;
+        freeList = nodes[index].parent;
+        nodes[index] = Node();
+        return index;
+    }
+
+    void release(int index)
+    {
+        nodes[index].parent = freeList;
+        nodes[index].height = -1;
+        freeList = index;
+    }
+
+    // pruned depth-first walk; enter(box) decides whether a node is visited
+    template<class Test, class F>
+    void walk(Test&& enter, F&& fn) const
+    {
+        if (root < 0) return;
+        int stack[AABB_TREE_STACK];
+        int top = 0;
+        stack[top++] = root;
+        while (top > 0)
+        {
+            const int index = stack[--top];
+            const Node& n = nodes[index];
+            if (!enter(n.box)) continue;
+            if (n.height == 0)
+            {
+                if (!fn(index)) return;
+                continue;
+            }
+            if (top + 2 > AABB_TREE_STACK) continue;
+            stack[top++] = n.child1;
+            stack[top++] = n.child2;
+        }
+    }
+
+    void insertLeaf(int leaf)
+    {
+        if (root < 0)
+        {
+            root = leaf;
+            nodes[leaf].parent = -1;
+            return;
+        }
+
+        // the sibling whose box grows the least, counting what every ancestor grows too
+        const AABB box = nodes[leaf].box;
+        int index = root;
+        while (nodes[index].height > 0)
+        {
+            const Node& n = nodes[index];
+            const float area = n.box.area();
+            const float combined = AABB::merge(n.box, box).area();
+            const float cost = 2.0f * combined;                  // new parent of this node and the leaf
+            const float inherited = 2.0f * (combined - area);    // what pushing further down adds above
+
+            float childCost[2];
+            const int children[2] = { n.child1, n.child2 };
+            for (int k = 0; k < 2; k++)
+            {
+                const Node& c = nodes[children[k]];
+                const float merged = AABB::merge(c.box, box).area();
+                childCost[k] = (c.height == 0 ? merged : merged - c.box.area()) + inherited;
+            }
+
+            if (cost < childCost[0] && cost < childCost[1]) break;
+            index = childCost[0] < childCost[1] ? n.child1 : n.child2;
+        }
+
+        const int sibling = index;
+        const int oldParent = nodes[sibling].parent;
+        const int newParent = allocate();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = AABB::merge(box, nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+        if (oldParent < 0) root = newParent;
+        else if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+        else nodes[oldParent].child2 = newParent;
+
+        refit(nodes[leaf].parent);
+    }
+
+    void removeLeaf(int leaf)
+    {
+        if (leaf == root)
+        {
+            root = -1;
+            return;
+        }
+
+        const int parent = nodes[leaf].parent;
+        const int grandParent = nodes[parent].parent;
+        const int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+        release(parent);
+
+        nodes[sibling].parent = grandParent;
+        if (grandParent < 0)
+        {
+            root = sibling;
+            return;
+        }
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else nodes[grandParent].child2 = sibling;
+        refit(grandParent);
+    }
+
+    // boxes and heights from 'index' up to the root, rebalancing on the way
+    void refit(int index)
+    {
+        while (index >= 0)
+        {
+            index = balance(index);
+            Node& n = nodes[index];
+            n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+            n.box = AABB::merge(nodes[n.child1].box, nodes[n.child2].box);
+            index = n.parent;
+        }
+    }
+
+    // AVL rotation: when one child of A is more than one level taller than the other, that
+    // child takes A's place and A takes over its lower grandchild. returns the subtree's new root
+    int balance(int a)
+    {
+        if (nodes[a].height < 2) return a;
+
+        const int b = nodes[a].child1, c = nodes[a].child2;
+        const int diff = nodes[c].height - nodes[b].height;
+        if (diff > 1) return rotate(a, c, b, false);
+        if (diff < -1) return rotate(a, b, c, true);
+        return a;
+    }
+
+    // 'up' (a child of 'a') replaces 'a'; 'other' is a's remaining child.
+    // upIsChild1: 'up' is a.child1, so a's child1 slot is the one refilled
+    int rotate(int a, int up, int other, bool upIsChild1)
+    {
+        const int f = nodes[up].child1, g = nodes[up].child2;
+
+        // up takes a's place under a's parent
+        nodes[up].child1 = a;
+        nodes[up].parent = nodes[a].parent;
+        nodes[a].parent = up;
+        const int p = nodes[up].parent;
+        if (p < 0) root = up;
+        else if (nodes[p].child1 == a) nodes[p].child1 = up;
+        else nodes[p].child2 = up;
+
+        // the taller grandchild stays with 'up', the shorter goes down to 'a'
+        const int keep = nodes[f].height > nodes[g].height ? f : g;
+        const int give = keep == f ? g : f;
+        nodes[up].child2 = keep;
+        if (upIsChild1) nodes[a].child1 = give;
+        else nodes[a].child2 = give;
+        nodes[give].parent = a;
+
+        nodes[a].box = AABB::merge(nodes[other].box, nodes[give].box);
+        nodes[a].height = 1 + std::max(nodes[other].height, nodes[give].height);
+        nodes[up].box = AABB::merge(nodes[a].box, nodes[keep].box);
+        nodes[up].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+        return up;
+    }
+};
+
+#endif
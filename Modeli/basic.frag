@@ -1,16 +1,34 @@
 #version 330 core
+// features (see ShaderVariants): UNLIT, PICK
+#ifdef PICK
+out uint FragId;   // R32UI target of the ID pass (see pick_buffer.hpp)
+flat in uint chPickId;
+#else
 out vec4 FragColor;
+#endif
 
 in vec3 chNormal;  
 in vec3 chFragPos;  
+flat in vec3 chColor; // цвет объекта
 
-uniform vec3 uLightPos; 
-uniform vec3 uViewPos; 
-uniform vec3 uLightColor;
-uniform vec3 uObjectColor; //  
+layout (std140) uniform FrameData
+{
+    mat4 uP;
+    mat4 uV;
+    mat4 uVP;
+    vec3 uLightPos;
+    vec3 uViewPos;
+    vec3 uLightColor;
+};
 
 void main()
 {    
+#if defined(PICK)
+    FragId = chPickId;
+#elif defined(UNLIT)
+    // flat emissive color (lamp), no lighting at all
+    FragColor = vec4(chColor, 1.0);
+#else
     // ambient
     float ambientStrength = 0.2;
     vec3 ambient = ambientStrength * uLightColor;
@@ -28,6 +46,7 @@ void main()
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
     vec3 specular = specularStrength * spec * uLightColor;  
 
-    vec3 result = (ambient + diffuse + specular) * uObjectColor;
+    vec3 result = (ambient + diffuse + specular) * chColor;
     FragColor = vec4(result, 1.0);
+#endif
 }
\ No newline at end of file
@@ -1,17 +1,115 @@
 #version 330 core
+// features (see ShaderVariants): UNLIT, INSTANCED, WATER, PARTICLE, PICK
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
+#ifdef INSTANCED
+layout (location = 2) in int inObjectIndex;   // per instance (see cube_batch.hpp)
+#endif
+#ifdef PARTICLE
+// per instance, one stream per axis (see particles.hpp)
+layout (location = 3) in float inParticleX;
+layout (location = 4) in float inParticleY;
+layout (location = 5) in float inParticleZ;
+layout (location = 6) in float inParticleVY;
+uniform vec3 uParticleSize;
+uniform float uParticleLag;   // seconds since the previous simulation tick still to cover
+#endif
 
 out vec3 chFragPos;
 out vec3 chNormal;
+flat out vec3 chColor;
+#ifdef PICK
+flat out uint chPickId;   // ID pass (see pick_buffer.hpp)
+#endif
 
-uniform mat4 uM;
-uniform mat4 uV;
-uniform mat4 uP;
+layout (std140) uniform FrameData
+{
+    mat4 uP;
+    mat4 uV;
+    mat4 uVP;
+    vec3 uLightPos;
+    vec3 uViewPos;
+    vec3 uLightColor;
+};
+
+// per-object records, OBJECT_TEXELS texels each (see object_buffer.hpp)
+uniform samplerBuffer uObjects;
+#ifndef INSTANCED
+uniform int uObjectIndex;
+#endif
+
+#ifdef WATER
+// unit water body (see water.hpp): xz on the unit disc, y = 0 bottom ring / 1 surface
+uniform vec4 uWaterShape;     // bottom radius, surface radius, bottom y, surface y
+uniform sampler2D uRipples;   // ripple heightfield over the disc's bounding square
+uniform float uRippleScale;   // heightfield unit -> world units
+
+// object-space position + normal of a unit-mesh vertex
+void waterVertex(out vec3 pos, out vec3 normal)
+{
+    float r = mix(uWaterShape.x, uWaterShape.y, inPos.y);
+    pos = vec3(inPos.x * r, mix(uWaterShape.z, uWaterShape.w, inPos.y), inPos.z * r);
+    normal = inNormal;
+    if (inPos.y < 0.5) return;
+
+    vec2 uv = inPos.xz * 0.5 + 0.5;
+    pos.y += textureLod(uRipples, uv, 0.0).r * uRippleScale;
+
+    // surface normal from the heightfield slope (the rim of the side wall only moves)
+    if (inNormal.y > 0.99)
+    {
+        float texel = 1.0 / float(textureSize(uRipples, 0).x);
+        float hx = textureLod(uRipples, uv + vec2(texel, 0.0), 0.0).r - textureLod(uRipples, uv - vec2(texel, 0.0), 0.0).r;
+        float hz = textureLod(uRipples, uv + vec2(0.0, texel), 0.0).r - textureLod(uRipples, uv - vec2(0.0, texel), 0.0).r;
+        float span = 2.0 * texel * 2.0 * uWaterShape.y;   // world distance between the samples
+        normal = normalize(vec3(-hx * uRippleScale / span, 1.0, -hz * uRippleScale / span));
+    }
+}
+#endif
+
+mat4 objectModel(int i)
+{
+    int b = i * 8;
+    return mat4(texelFetch(uObjects, b), texelFetch(uObjects, b + 1),
+                texelFetch(uObjects, b + 2), texelFetch(uObjects, b + 3));
+}
+
+// inverse-transpose of the model matrix, precomputed on the CPU
+mat3 objectNormal(int i)
+{
+    int b = i * 8 + 4;
+    return mat3(texelFetch(uObjects, b).xyz, texelFetch(uObjects, b + 1).xyz,
+                texelFetch(uObjects, b + 2).xyz);
+}
 
 void main()
 {
-    chFragPos = vec3(uM * vec4(inPos, 1.0));
-    chNormal = mat3(transpose(inverse(uM))) * inNormal;
-    gl_Position = uP * uV * vec4(chFragPos, 1.0);
+#ifdef INSTANCED
+    int object = inObjectIndex;
+#else
+    int object = uObjectIndex;
+#endif
+    mat4 M = objectModel(object);
+    chColor = texelFetch(uObjects, object * 8 + 7).rgb;
+#ifdef PICK
+    chPickId = uint(texelFetch(uObjects, object * 8 + 4).w);
+#endif
+
+#ifdef WATER
+    vec3 pos, normal;
+    waterVertex(pos, normal);
+#elif defined(PARTICLE)
+    // the last tick moved the droplet by vy * dt: back up along it to the interpolated position
+    vec3 pos = inPos * uParticleSize + vec3(inParticleX, inParticleY - inParticleVY * uParticleLag, inParticleZ);
+    vec3 normal = inNormal / uParticleSize;
+#else
+    vec3 pos = inPos;
+    vec3 normal = inNormal;
+#endif
+
+    chFragPos = vec3(M * vec4(pos, 1.0));
+#ifndef UNLIT
+    chNormal = objectNormal(object) * normal;
+#endif
+    gl_Position = uVP * vec4(chFragPos, 1.0);
 }
@@ -0,0 +1,8 @@
+#version 330 core
+// color writes are masked off while the box is drawn; only the samples are counted
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0);
+}
\ No newline at end of file
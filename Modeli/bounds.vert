@@ -0,0 +1,20 @@
+#version 330 core
+// bounding box of an occlusion query (unit cube scaled by uM), depth only
+layout (location = 0) in vec3 inPos;
+
+layout (std140) uniform FrameData
+{
+    mat4 uP;
+    mat4 uV;
+    mat4 uVP;
+    vec3 uLightPos;
+    vec3 uViewPos;
+    vec3 uLightColor;
+};
+
+uniform mat4 uM;
+
+void main()
+{
+    gl_Position = uVP * (uM * vec4(inPos, 1.0));
+}
\ No newline at end of file
@@ -4,6 +4,33 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+// view frustum as 6 planes (xyz = inward unit normal, w = distance):
+// a point p is inside a plane when dot(xyz, p) + w >= 0.
+// order: left, right, bottom, top, near, far
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // Gribb/Hartmann: the planes are sums/differences of the rows of the clip matrix
+    static Frustum fromMatrix(const glm::mat4& VP)
+    {
+        glm::vec4 r0(VP[0][0], VP[1][0], VP[2][0], VP[3][0]);
+        glm::vec4 r1(VP[0][1], VP[1][1], VP[2][1], VP[3][1]);
+        glm::vec4 r2(VP[0][2], VP[1][2], VP[2][2], VP[3][2]);
+        glm::vec4 r3(VP[0][3], VP[1][3], VP[2][3], VP[3][3]);
+
+        Frustum f;
+        f.planes[0] = r3 + r0;
+        f.planes[1] = r3 - r0;
+        f.planes[2] = r3 + r1;
+        f.planes[3] = r3 - r1;
+        f.planes[4] = r3 + r2;
+        f.planes[5] = r3 - r2;
+        for (glm::vec4& p : f.planes)
+            p /= glm::length(glm::vec3(p));
+        return f;
+    }
+};
+
 enum Camera_Movement {
     FORWARD,
     BACKWARD,
@@ -25,7 +52,7 @@ public:
     float MovementSpeed = 3.0f;
     float MouseSensitivity = 0.1f;
 
-    //  
+    // границы комнаты
     float RoomLimit = 2.8f;
     float EyeHeight = 1.5f;
 
@@ -43,11 +70,17 @@ public:
         return glm::lookAt(Position, Position + Front, Up);
     }
 
+    // frustum planes of this camera seen through 'projection'
+    Frustum GetFrustum(const glm::mat4& projection)
+    {
+        return Frustum::fromMatrix(projection * GetViewMatrix());
+    }
+
     void ProcessKeyboard(Camera_Movement direction, float deltaTime)
     {
         float velocity = MovementSpeed * deltaTime;
 
-        //   
+        // Убираем вертикальное движение
         glm::vec3 flatFront = glm::normalize(glm::vec3(Front.x, 0.0f, Front.z));
         glm::vec3 flatRight = glm::normalize(glm::vec3(Right.x, 0.0f, Right.z));
 
@@ -63,10 +96,10 @@ public:
         if (direction == RIGHT)
             Position += flatRight * velocity;
 
-        //  
+        // фиксируем высоту
         Position.y = EyeHeight;
 
-        //    
+        // ограничиваем движение по комнате
         Position.x = glm::clamp(Position.x, -RoomLimit, RoomLimit);
         Position.z = glm::clamp(Position.z, -RoomLimit, RoomLimit);
     }
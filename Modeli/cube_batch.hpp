@@ -0,0 +1,131 @@
+#ifndef CUBE_BATCH_H
+#define CUBE_BATCH_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "object_buffer.hpp"
+#include "culling.hpp"
+#include "shader_variants.hpp"
+
+#include <vector>
+#include <algorithm>
+
+// attribute location of the per-instance object index (basic.vert, INSTANCED)
+const unsigned int CUBE_INSTANCE_ATTRIB = 2;
+
+// Collects every unit cube of a frame and draws them instanced.
+// add() stores the transform + color in the object buffer like any other object; the only
+// per-instance attribute is the record index, so a flush is one glDrawArraysInstanced per
+// shader variant (lit / unlit), however many cubes were added.
+class CubeBatch {
+public:
+    // cubeVBO: 36 vertices of position + normal (6 floats), as built by initCube()
+    void init(unsigned int cubeVBO, ObjectBuffer& objectBuffer, FrustumCuller& culler)
+    {
+        objects = &objectBuffer;
+        frustum = &culler;
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &instanceVBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(int), nullptr, GL_STREAM_DRAW);
+        glVertexAttribIPointer(CUBE_INSTANCE_ATTRIB, 1, GL_INT, sizeof(int), (void*)0);
+        glEnableVertexAttribArray(CUBE_INSTANCE_ATTRIB);
+        glVertexAttribDivisor(CUBE_INSTANCE_ATTRIB, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void clear()
+    {
+        cubes.clear();
+    }
+
+    // M maps the unit cube [-0.5, 0.5] into the world; 'features' picks the shader variant
+    void add(const glm::mat4& M, const glm::vec3& color, unsigned int features)
+    {
+        Cube c;
+        c.object = objects->push(M, color);
+        c.bounds = frustum->add(M, glm::vec3(-0.5f), glm::vec3(0.5f));
+        c.features = features;
+        cubes.push_back(c);
+    }
+
+    // draws every visible cube; expects the object buffer uploaded + bound.
+    // 'instancedFeature' is or-ed into every variant request
+    void flush(ShaderVariants& shaders, unsigned int instancedFeature)
+    {
+        // visible cubes grouped by variant, in submission order inside a group
+        visible.clear();
+        for (const Cube& c : cubes)
+            if (frustum->visible(c.bounds)) visible.push_back(c);
+        std::stable_sort(visible.begin(), visible.end(), [](const Cube& a, const Cube& b) {
+            return a.features < b.features;
+        });
+        if (visible.empty()) return;
+
+        indices.resize(visible.size());
+        for (size_t i = 0; i < visible.size(); i++)
+            indices[i] = visible[i].object;
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (indices.size() > capacity) {
+            while (capacity < indices.size()) capacity *= 2;
+        }
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(int), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, indices.size() * sizeof(int), indices.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glBindVertexArray(VAO);
+        size_t first = 0;
+        while (first < visible.size())
+        {
+            size_t last = first;
+            while (last < visible.size() && visible[last].features == visible[first].features) last++;
+
+            shaders.get(visible[first].features | instancedFeature).use();
+            // glDrawArraysInstancedBaseInstance is GL 4.2; the group offset goes into the attribute pointer
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            glVertexAttribIPointer(CUBE_INSTANCE_ATTRIB, 1, GL_INT, sizeof(int), (void*)(first * sizeof(int)));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)(last - first));
+
+            first = last;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    int size() const
+    {
+        return (int)cubes.size();
+    }
+
+private:
+    struct Cube {
+        int object;
+        int bounds;
+        unsigned int features;
+    };
+    std::vector<Cube> cubes;
+    std::vector<Cube> visible;
+    std::vector<int> indices;
+
+    ObjectBuffer* objects = nullptr;
+    FrustumCuller* frustum = nullptr;
+    unsigned int VAO = 0;
+    unsigned int instanceVBO = 0;
+    size_t capacity = 256;
+};
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX__)
+#define CULLING_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE 1
+#include <emmintrin.h>
+#endif
+
+// world-space bounding sphere of a local box [lo, hi] transformed by M.
+// the box corners end up at c +- a +- b +- d, so the farthest one is found among 4 diagonals
+// (exact for any affine M, including shear).
+static inline glm::vec4 boundingSphere(const glm::mat4& M, const glm::vec3& lo, const glm::vec3& hi)
+{
+    glm::vec3 center = glm::vec3(M * glm::vec4((lo + hi) * 0.5f, 1.0f));
+    glm::vec3 e = (hi - lo) * 0.5f;
+    glm::vec3 a = glm::vec3(M[0]) * e.x;
+    glm::vec3 b = glm::vec3(M[1]) * e.y;
+    glm::vec3 d = glm::vec3(M[2]) * e.z;
+
+    float r2 = glm::dot(a + b + d, a + b + d);
+    r2 = std::max(r2, glm::dot(a + b - d, a + b - d));
+    r2 = std::max(r2, glm::dot(a - b + d, a - b + d));
+    r2 = std::max(r2, glm::dot(-a + b + d, -a + b + d));
+    return glm::vec4(center, std::sqrt(r2));
+}
+
+struct CullStats {
+    int tested = 0;
+    int culled = 0;     // outside the frustum
+    int occluded = 0;   // inside, but rejected by a later pass (see OcclusionCuller)
+    int drawn = 0;
+};
+
+// Per-frame frustum test of every submitted object.
+// bounds are collected as spheres in SoA arrays while the frame is recorded, then run()
+// tests all of them against the 6 planes in one pass (8 spheres per step with AVX,
+// 4 with SSE2, scalar otherwise) and visible(i) answers per object.
+class FrustumCuller {
+public:
+    bool enabled = true;
+
+    void clear()
+    {
+        cx.clear(); cy.clear(); cz.clear(); r.clear();
+        result.clear();
+        stats = CullStats();
+    }
+
+    // returns the id to ask visible() with after run()
+    int add(const glm::vec4& sphere)
+    {
+        cx.push_back(sphere.x);
+        cy.push_back(sphere.y);
+        cz.push_back(sphere.z);
+        r.push_back(sphere.w);
+        return (int)cx.size() - 1;
+    }
+
+    int add(const glm::mat4& M, const glm::vec3& lo, const glm::vec3& hi)
+    {
+        return add(boundingSphere(M, lo, hi));
+    }
+
+    void run(const Frustum& frustum)
+    {
+        const size_t n = cx.size();
+        result.assign(n, 1);
+        stats.tested = (int)n;
+        if (!enabled || n == 0)
+        {
+            stats.culled = 0;
+            stats.drawn = (int)n;
+            return;
+        }
+
+        // pad to a whole SIMD step; padded lanes are never read back
+        const size_t padded = (n + 7) & ~(size_t)7;
+        cx.resize(padded, 0.0f); cy.resize(padded, 0.0f); cz.resize(padded, 0.0f); r.resize(padded, 0.0f);
+        result.resize(padded, 1);
+
+        testSpheres(frustum, padded);
+
+        cx.resize(n); cy.resize(n); cz.resize(n); r.resize(n);
+        result.resize(n);
+
+        int visibleCount = 0;
+        for (uint8_t v : result) visibleCount += v;
+        stats.drawn = visibleCount;
+        stats.culled = (int)n - visibleCount;
+    }
+
+    // id < 0 means "no bounds recorded", which is always drawn
+    bool visible(int id) const
+    {
+        return id < 0 || id >= (int)result.size() || result[id] != 0;
+    }
+
+    // lets a later pass hide an object that passed the frustum test
+    void reject(int id)
+    {
+        if (id < 0 || id >= (int)result.size() || !result[id]) return;
+        result[id] = 0;
+        stats.occluded++;
+        stats.drawn--;
+    }
+
+    int count() const
+    {
+        return (int)cx.size();
+    }
+
+    glm::vec4 sphere(int id) const
+    {
+        return glm::vec4(cx[id], cy[id], cz[id], r[id]);
+    }
+
+    const CullStats& frameStats() const
+    {
+        return stats;
+    }
+
+private:
+    std::vector<float> cx, cy, cz, r;
+    std::vector<uint8_t> result;
+    CullStats stats;
+
+    // a sphere is outside when it is entirely behind any plane: dot(n, c) + w < -r
+    void testSpheres(const Frustum& f, size_t count)
+    {
+#if defined(CULLING_AVX)
+        for (size_t i = 0; i < count; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(&cx[i]);
+            __m256 y = _mm256_loadu_ps(&cy[i]);
+            __m256 z = _mm256_loadu_ps(&cz[i]);
+            __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&r[i]));
+            __m256 outside = _mm256_setzero_ps();
+            for (const glm::vec4& p : f.planes)
+            {
+                __m256 d = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(p.x)), _mm256_mul_ps(y, _mm256_set1_ps(p.y))),
+                    _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(p.z)), _mm256_set1_ps(p.w)));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, negR, _CMP_LT_OQ));
+            }
+            int mask = _mm256_movemask_ps(outside);
+            for (int k = 0; k < 8; k++)
+                result[i + k] = (uint8_t)!((mask >> k) & 1);
+        }
+#elif defined(CULLING_SSE)
+        for (size_t i = 0; i < count; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&cx[i]);
+            __m128 y = _mm_loadu_ps(&cy[i]);
+            __m128 z = _mm_loadu_ps(&cz[i]);
+            __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&r[i]));
+            __m128 outside = _mm_setzero_ps();
+            for (const glm::vec4& p : f.planes)
+            {
+                __m128 d = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.x)), _mm_mul_ps(y, _mm_set1_ps(p.y))),
+                    _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negR));
+            }
+            int mask = _mm_movemask_ps(outside);
+            for (int k = 0; k < 4; k++)
+                result[i + k] = (uint8_t)!((mask >> k) & 1);
+        }
+#else
+        for (size_t i = 0; i < count; i++)
+        {
+            bool outside = false;
+            for (const glm::vec4& p : f.planes)
+                outside |= p.x * cx[i] + p.y * cy[i] + p.z * cz[i] + p.w < -r[i];
+            result[i] = (uint8_t)!outside;
+        }
+#endif
+    }
+};
+
+#endif
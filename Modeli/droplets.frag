@@ -0,0 +1,8 @@
+#version 330 core
+// shared by the droplet update (rasterizer discard, never runs) and impact count passes
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0);
+}
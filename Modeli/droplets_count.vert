@@ -0,0 +1,9 @@
+#version 330 core
+// impact counter: droplets that landed this step become a point on the single pixel of a
+// 1x1 target, the rest are clipped; GL_SAMPLES_PASSED then is the number of impacts
+layout (location = 0) in float inHit;
+
+void main()
+{
+    gl_Position = inHit > 0.5 ? vec4(0.0, 0.0, 0.0, 1.0) : vec4(2.0, 2.0, 2.0, 1.0);
+}
@@ -0,0 +1,58 @@
+#version 330 core
+// one droplet per vertex, written back with transform feedback (see gpu_droplets.hpp);
+// same rules as DropletSystem in particles.hpp
+layout (location = 0) in vec4 inState;   // x, y, z, vertical speed
+layout (location = 1) in uint inSeed;
+
+out vec4 tfState;
+flat out uint tfSeed;
+out float tfHit;                         // 1 when it landed in the basin this step
+
+uniform vec3 uOrigin;      // outlet
+uniform float uJitter;
+uniform float uGravity;
+uniform float uDt;
+uniform vec4 uCapture;     // basin center x, center z, radius^2, water surface y
+uniform float uKillY;
+uniform bool uRespawnAll;
+
+// integer hash (lowbias32), the droplet's whole RNG; randomHash() / randomNext01() in random.hpp
+uint hash(uint x)
+{
+    x ^= x >> 16u;
+    x *= 0x7feb352du;
+    x ^= x >> 15u;
+    x *= 0x846ca68bu;
+    x ^= x >> 16u;
+    return x;
+}
+
+float next01(inout uint seed)
+{
+    seed = hash(seed);
+    return float(seed >> 8u) * (1.0 / 16777216.0);
+}
+
+void main()
+{
+    vec4 s = inState;
+    uint seed = inSeed;
+
+    s.w -= uGravity * uDt;
+    s.y += s.w * uDt;
+
+    vec2 d = s.xz - uCapture.xy;
+    bool captured = !uRespawnAll && s.y <= uCapture.w && dot(d, d) <= uCapture.z;
+    if (captured || uRespawnAll || s.y < uKillY)
+    {
+        s.x = uOrigin.x + (next01(seed) * 2.0 - 1.0) * uJitter;
+        s.y = uOrigin.y;
+        s.z = uOrigin.z + (next01(seed) * 2.0 - 1.0) * uJitter;
+        s.w = -0.2 - next01(seed) * 0.3;
+    }
+
+    tfState = s;
+    tfSeed = seed;
+    tfHit = captured ? 1.0 : 0.0;
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);   // rasterizer discard is on
+}
@@ -0,0 +1,75 @@
+#ifndef FIXED_STEP_H
+#define FIXED_STEP_H
+
+#include <algorithm>
+
+// Fixed-timestep scheduler for the simulation.
+// every frame advance() is told how much real time passed and answers how many ticks of
+// exactly step() seconds to run, so the simulation sees the same dt at 30 Hz and at 240 Hz
+// rendering. after a hitch at most 'maxTicks' are run and the rest of the backlog is dropped
+// (the simulation slows down instead of spiralling). alpha() is how far the renderer is
+// between the last two ticks, for interpolating what it draws.
+class FixedStep {
+public:
+    explicit FixedStep(float ticksPerSecond = 120.0f, int maxTicksPerFrame = 8)
+        : maxTicks(maxTicksPerFrame)
+    {
+        setRate(ticksPerSecond);
+    }
+
+    void setRate(float ticksPerSecond)
+    {
+        dt = 1.0f / std::max(ticksPerSecond, 1.0f);
+        accumulator = std::min(accumulator, dt);
+    }
+
+    // number of ticks to run for 'frameTime' seconds of real time
+    int advance(float frameTime)
+    {
+        accumulator += std::max(frameTime, 0.0f);
+        int ticks = (int)(accumulator / dt);
+        if (ticks > maxTicks)
+        {
+            dropped += ticks - maxTicks;
+            ticks = maxTicks;
+            accumulator = dt * 0.999f;   // keep the fraction below one tick
+        }
+        else
+        {
+            accumulator -= ticks * dt;
+        }
+        total += ticks;
+        return ticks;
+    }
+
+    float step() const
+    {
+        return dt;
+    }
+
+    // 0..1: time since the last tick, in ticks
+    float alpha() const
+    {
+        return std::min(accumulator / dt, 1.0f);
+    }
+
+    long long ticks() const
+    {
+        return total;
+    }
+
+    // ticks skipped by the catch-up cap so far
+    long long droppedTicks() const
+    {
+        return dropped;
+    }
+
+private:
+    float dt = 1.0f / 120.0f;
+    float accumulator = 0.0f;
+    int maxTicks;
+    long long total = 0;
+    long long dropped = 0;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "shader.hpp"
+
+// binding point of the "FrameData" uniform block (see basic.vert, model.vert, tex.vert)
+const unsigned int FRAME_DATA_BINDING = 0;
+
+// CPU mirror of the std140 "FrameData" block.
+// every vec3 is followed by a float so it fills the whole 16 byte std140 slot.
+struct FrameData {
+    glm::mat4 P;
+    glm::mat4 V;
+    glm::mat4 VP;
+    glm::vec3 lightPos;   float pad0;
+    glm::vec3 viewPos;    float pad1;
+    glm::vec3 lightColor; float pad2;
+};
+static_assert(sizeof(FrameData) == 240, "FrameData must match the std140 layout of the shader block");
+
+// per-frame camera + lighting data, uploaded once per frame and shared by every program
+class FrameUniforms {
+public:
+    unsigned int UBO = 0;
+
+    void init()
+    {
+        glGenBuffers(1, &UBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        // the buffer stays on its binding point for the whole run
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, UBO);
+    }
+
+    // attach a program's "FrameData" block to the shared binding point (once, after linking)
+    void attach(Shader& shader) const
+    {
+        shader.bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+    }
+
+    void update(const glm::mat4& P, const glm::mat4& V,
+        const glm::vec3& lightPos, const glm::vec3& viewPos, const glm::vec3& lightColor)
+    {
+        FrameData d;
+        d.P = P;
+        d.V = V;
+        d.VP = P * V;
+        d.lightPos = lightPos;     d.pad0 = 0.0f;
+        d.viewPos = viewPos;       d.pad1 = 0.0f;
+        d.lightColor = lightColor; d.pad2 = 0.0f;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &d);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+};
+
+#endif
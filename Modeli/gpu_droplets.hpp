@@ -0,0 +1,272 @@
+#ifndef GPU_DROPLETS_H
+#define GPU_DROPLETS_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "shader.hpp"
+#include "shader_variants.hpp"
+#include "object_buffer.hpp"
+#include "culling.hpp"
+#include "particles.hpp"
+#include "random.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// frames an impact count may take to come back; the query pool holds this many frames of steps
+const int GPU_DROPLET_LATENCY = 4;
+
+// GPU-resident alternative to DropletSystem (same emitter, same capture rules).
+// the state lives in two buffers; every frame droplets_update.vert reads one and writes the
+// other with transform feedback (rasterizer discard on), respawning from an integer hash
+// per droplet. the CPU never touches a droplet:
+//  - rendering reads the positions straight out of the feedback buffer (PARTICLE variant)
+//  - impacts are counted by drawing the landed ones as points onto a 1x1 target inside a
+//    GL_SAMPLES_PASSED query (GL 3.3 has no atomic counters), read back without waiting
+// on a software rasterizer (llvmpipe) the update runs as its JIT-vectorized vertex shader.
+class GpuDroplets {
+public:
+    bool enabled = false;
+
+    // updateProgram: droplets_update.vert with feedback "tfState", "tfSeed", "tfHit"
+    // countProgram: droplets_count.vert; cubeVBO: unit cube, position + normal (6 floats)
+    // stepsPerFrame: the most step() calls a frame makes (the simulation's tick cap)
+    void init(Shader& updateProgram, Shader& countProgram, unsigned int cubeVBO, size_t droplets, uint32_t seed, int stepsPerFrame)
+    {
+        update = &updateProgram;
+        counter = &countProgram;
+        count = (GLsizei)droplets;
+        sampler.reseed(seed, 1);
+
+        // below the kill plane, so the first step respawns all of them. seeds as in
+        // DropletSystem::init, so a landed droplet respawns from the same stream in both
+        std::vector<State> initial(droplets);
+        for (size_t i = 0; i < droplets; i++)
+            initial[i] = { 0.0f, -1.0e6f, 0.0f, 0.0f, randomSeed(seed, i), 0.0f };
+
+        glGenBuffers(2, buffers);
+        glGenVertexArrays(2, updateVAO);
+        glGenVertexArrays(2, countVAO);
+        glGenVertexArrays(2, drawVAO);
+        for (int k = 0; k < 2; k++)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[k]);
+            glBufferData(GL_ARRAY_BUFFER, droplets * sizeof(State), initial.data(), GL_DYNAMIC_COPY);
+
+            glBindVertexArray(updateVAO[k]);
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(State), (void*)offsetof(State, x));
+            glEnableVertexAttribArray(0);
+            glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(State), (void*)offsetof(State, seed));
+            glEnableVertexAttribArray(1);
+
+            glBindVertexArray(countVAO[k]);
+            glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, sizeof(State), (void*)offsetof(State, hit));
+            glEnableVertexAttribArray(0);
+
+            // unit cube per droplet, position streams interleaved in the state
+            glBindVertexArray(drawVAO[k]);
+            glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[k]);
+            const unsigned int attribs[4] = { PARTICLE_ATTRIB_X, PARTICLE_ATTRIB_Y, PARTICLE_ATTRIB_Z, PARTICLE_ATTRIB_VY };
+            for (int a = 0; a < 4; a++)
+            {
+                glVertexAttribPointer(attribs[a], 1, GL_FLOAT, GL_FALSE, sizeof(State), (void*)(offsetof(State, x) + a * sizeof(float)));
+                glEnableVertexAttribArray(attribs[a]);
+                glVertexAttribDivisor(attribs[a], 1);
+            }
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // the 1x1 target of the impact count
+        glGenRenderbuffers(1, &countTarget);
+        glBindRenderbuffer(GL_RENDERBUFFER, countTarget);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_R8, 1, 1);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glGenFramebuffers(1, &countFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, countFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, countTarget);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // a count per step, GPU_DROPLET_LATENCY frames of them at the lowest frame rate
+        queries.resize((size_t)std::max(1, stepsPerFrame) * GPU_DROPLET_LATENCY);
+        glGenQueries((GLsizei)queries.size(), queries.data());
+    }
+
+    // every droplet back at the outlet on the next update
+    void respawnAll()
+    {
+        respawn = true;
+    }
+
+    // one simulation step on the GPU. the impact count returned is the one the GPU finished
+    // since the last call (from an earlier step); ripple positions are drawn from the spawn
+    // square, which is where droplets land
+    DropletImpacts step(float dt, const DropletParams& p)
+    {
+        DropletImpacts impacts;
+        impacts.count = collect();
+        if (count == 0) return impacts;
+
+        // 1. state: buffers[current] -> buffers[1 - current]
+        const int next = 1 - current;
+        update->use();
+        update->setVec3(U_ORIGIN, p.origin);
+        update->setFloat(U_JITTER, p.jitter);
+        update->setFloat(U_GRAVITY, p.gravity);
+        update->setFloat(U_DT, dt);
+        update->setVec4(U_CAPTURE, p.captureCenter.x, p.captureCenter.y, p.captureRadius * p.captureRadius, p.captureY);
+        update->setFloat(U_KILL_Y, p.killY);
+        update->setBool(U_RESPAWN_ALL, respawn);
+        const bool counted = !respawn;
+        respawn = false;
+
+        glEnable(GL_RASTERIZER_DISCARD);
+        glBindVertexArray(updateVAO[current]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[next]);
+        glBeginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, count);
+        glEndTransformFeedback();
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+        glDisable(GL_RASTERIZER_DISCARD);
+        current = next;
+
+        // 2. impacts of this step, counted as samples on a 1x1 target. the pool only runs full
+        // if the GPU falls further behind than GPU_DROPLET_LATENCY frames: then the oldest count is
+        // waited for rather than this one dropped, so the basin fills the same at any frame rate
+        if (counted && inFlight == (int)queries.size())
+            impacts.count += collectOldest();
+        if (counted)
+        {
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+            glDisable(GL_DEPTH_TEST);
+            glBindFramebuffer(GL_FRAMEBUFFER, countFBO);
+            glViewport(0, 0, 1, 1);
+
+            counter->use();
+            const int slot = (oldest + inFlight) % (int)queries.size();
+            glBeginQuery(GL_SAMPLES_PASSED, queries[slot]);
+            glBindVertexArray(countVAO[current]);
+            glDrawArrays(GL_POINTS, 0, count);
+            glEndQuery(GL_SAMPLES_PASSED);
+            inFlight++;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            if (depth) glEnable(GL_DEPTH_TEST);
+        }
+        glBindVertexArray(0);
+
+        float jitter[2 * PARTICLE_IMPACT_SAMPLES];
+        const int sampled = std::min(impacts.count, PARTICLE_IMPACT_SAMPLES);
+        sampler.fill01(jitter, 2 * sampled, -p.jitter, p.jitter);
+        for (int k = 0; k < sampled; k++)
+            impacts.samples.push_back(glm::vec2(p.origin.x + jitter[2 * k], p.origin.z + jitter[2 * k + 1]));
+        return impacts;
+    }
+
+    // per frame, while recording; [lo, hi] is a world box holding every droplet
+    void submit(ObjectBuffer& objects, FrustumCuller& culler, const glm::vec3& color, const glm::vec3& lo, const glm::vec3& hi)
+    {
+        visible = true;
+        object = objects.push(glm::mat4(1.0f), color);
+        bounds = culler.add(glm::mat4(1.0f), lo, hi);
+    }
+
+    void hide()
+    {
+        visible = false;
+    }
+
+    // expects the object buffer uploaded + bound; 'feature' selects the PARTICLE variant.
+    // lag: as in ParticleRenderer::draw
+    void draw(ShaderVariants& shaders, unsigned int feature, UniformKey objectIndex,
+        const FrustumCuller& culler, const glm::vec3& size, float lag = 0.0f)
+    {
+        if (!visible || count == 0 || !culler.visible(bounds)) return;
+
+        Shader& shader = shaders.get(feature);
+        shader.use();
+        shader.setInt(objectIndex, object);
+        shader.setVec3(U_PARTICLE_SIZE, size);
+        shader.setFloat(U_PARTICLE_LAG, lag);
+
+        glBindVertexArray(drawVAO[current]);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, count);
+        glBindVertexArray(0);
+    }
+
+private:
+    // hashed at compile time
+    static constexpr UniformKey U_ORIGIN{ "uOrigin" };
+    static constexpr UniformKey U_JITTER{ "uJitter" };
+    static constexpr UniformKey U_GRAVITY{ "uGravity" };
+    static constexpr UniformKey U_DT{ "uDt" };
+    static constexpr UniformKey U_CAPTURE{ "uCapture" };
+    static constexpr UniformKey U_KILL_Y{ "uKillY" };
+    static constexpr UniformKey U_RESPAWN_ALL{ "uRespawnAll" };
+    static constexpr UniformKey U_PARTICLE_SIZE{ "uParticleSize" };
+    static constexpr UniformKey U_PARTICLE_LAG{ "uParticleLag" };
+
+    // one droplet as written by droplets_update.vert (tfState, tfSeed, tfHit interleaved)
+    struct State {
+        float x, y, z, vy;
+        uint32_t seed;
+        float hit;
+    };
+
+    Shader* update = nullptr;
+    Shader* counter = nullptr;
+    GLsizei count = 0;
+    GLuint buffers[2] = { 0, 0 };
+    GLuint updateVAO[2] = { 0, 0 };
+    GLuint countVAO[2] = { 0, 0 };
+    GLuint drawVAO[2] = { 0, 0 };
+    int current = 0;
+    bool respawn = false;
+
+    GLuint countFBO = 0, countTarget = 0;
+    std::vector<GLuint> queries;
+    int oldest = 0, inFlight = 0;
+
+    bool visible = false;
+    int object = -1;
+    int bounds = -1;
+    Random sampler;
+
+    // sum of every count the GPU has finished, oldest first; never waits
+    int collect()
+    {
+        int total = 0;
+        while (inFlight > 0)
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(queries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+            total += collectOldest();
+        }
+        return total;
+    }
+
+    // the oldest count, waiting for it if the GPU isn't done yet
+    int collectOldest()
+    {
+        GLuint samples = 0;
+        glGetQueryObjectuiv(queries[oldest], GL_QUERY_RESULT, &samples);
+        oldest = (oldest + 1) % (int)queries.size();
+        inFlight--;
+        return (int)samples;
+    }
+};
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef GPU_OCCLUSION_H
+#define GPU_OCCLUSION_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shader.hpp"
+#include "culling.hpp"
+
+#include <vector>
+
+// a visible object is only re-tested every this many frames
+const int GPU_OCCLUSION_REQUERY = 4;
+
+struct GpuOcclusionStats {
+    int queries = 0;    // boxes tested this frame
+    int occluded = 0;   // objects whose last known result was "hidden"
+};
+
+// Hardware occlusion queries for expensive draws (opt-in).
+// the bounding box of an object is drawn depth-only inside a GL_ANY_SAMPLES_PASSED query;
+// the object itself is drawn under glBeginConditionalRender(GL_QUERY_NO_WAIT) on the query
+// of an earlier frame, so neither CPU nor GPU ever waits on a result (NO_WAIT draws when
+// the answer isn't there yet).
+// temporal coherence: results are picked up on the CPU once available (no stall);
+// hidden objects are re-tested every frame so they reappear after one frame,
+// visible ones only every GPU_OCCLUSION_REQUERY frames and are drawn unconditionally between.
+class GpuOcclusion {
+public:
+    bool enabled = false;
+
+    // boxProgram: bounds.vert/bounds.frag, cubeVAO: unit cube [-0.5, 0.5] with positions at location 0
+    void init(Shader& boxProgram, unsigned int cubeVAO)
+    {
+        boxShader = &boxProgram;
+        boxVAO = cubeVAO;
+        uM = boxShader->uniform("uM");
+    }
+
+    // one slot per object that wants queries; returns its id
+    int track()
+    {
+        Slot s;
+        glGenQueries(2, s.query);
+        s.sinceQuery = (int)slots.size() % GPU_OCCLUSION_REQUERY;   // spread the re-tests over frames
+        slots.push_back(s);
+        return (int)slots.size() - 1;
+    }
+
+    void beginFrame()
+    {
+        stats = GpuOcclusionStats();
+    }
+
+    // draws 'draw' subject to the query policy. [lo, hi] is the model-space box, M places it
+    template <class F>
+    void draw(int id, const glm::mat4& M, const glm::vec3& lo, const glm::vec3& hi, const glm::vec3& eye, F&& drawObject)
+    {
+        if (id < 0 || id >= (int)slots.size())
+        {
+            drawObject();
+            return;
+        }
+        Slot& s = slots[id];
+
+        // off, no depth test (every box would pass), or the box would be cut by the near plane
+        // (the query could report 0 samples for something right in front of the camera)
+        glm::vec4 sphere = boundingSphere(M, lo, hi);
+        if (!enabled || !glIsEnabled(GL_DEPTH_TEST) || glm::length(glm::vec3(sphere) - eye) < sphere.w + NEAR_MARGIN)
+        {
+            s.pending = false;
+            s.known = false;
+            drawObject();
+            return;
+        }
+
+        collect(s);
+        if (s.known && !s.visible) stats.occluded++;
+
+        // condition on the last issued query unless it is known to have passed
+        const bool conditional = s.pending || (s.known && !s.visible);
+        const GLuint last = s.query[s.last];
+
+        if (!s.pending && (!s.known || !s.visible || s.sinceQuery >= GPU_OCCLUSION_REQUERY))
+        {
+            s.last = 1 - s.last;
+            drawBox(s.query[s.last], M, lo, hi);
+            s.pending = true;
+            s.sinceQuery = 0;
+            stats.queries++;
+        }
+        else
+        {
+            s.sinceQuery++;
+        }
+
+        if (conditional)
+        {
+            glBeginConditionalRender(last, GL_QUERY_NO_WAIT);
+            drawObject();
+            glEndConditionalRender();
+        }
+        else
+        {
+            drawObject();
+        }
+    }
+
+    const GpuOcclusionStats& frameStats() const
+    {
+        return stats;
+    }
+
+private:
+    static constexpr float NEAR_MARGIN = 0.15f;   // > near plane distance
+
+    struct Slot {
+        GLuint query[2] = { 0, 0 };
+        int last = 0;           // query[last] is the most recently issued one
+        bool pending = false;   // query[last] issued, result not read back yet
+        bool known = false;     // 'visible' holds the result of query[last]
+        bool visible = true;
+        int sinceQuery = 0;
+    };
+    std::vector<Slot> slots;
+    Shader* boxShader = nullptr;
+    unsigned int boxVAO = 0;
+    Uniform uM;
+    GpuOcclusionStats stats;
+
+    // reads the last result if the GPU already has it; never waits
+    void collect(Slot& s)
+    {
+        if (!s.pending) return;
+        GLuint available = 0;
+        glGetQueryObjectuiv(s.query[s.last], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+        GLuint anySamples = 0;
+        glGetQueryObjectuiv(s.query[s.last], GL_QUERY_RESULT, &anySamples);
+        s.pending = false;
+        s.known = true;
+        s.visible = anySamples != 0;
+    }
+
+    void drawBox(GLuint query, const glm::mat4& M, const glm::vec3& lo, const glm::vec3& hi)
+    {
+        glm::mat4 box = glm::translate(M, (lo + hi) * 0.5f);
+        box = glm::scale(box, glm::max(hi - lo, glm::vec3(1e-4f)));
+
+        GLboolean cull = glIsEnabled(GL_CULL_FACE);
+        glDisable(GL_CULL_FACE);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+
+        boxShader->use();
+        boxShader->setMat4(uM, box);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+        glBindVertexArray(boxVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glBindVertexArray(0);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+        glDepthMask(GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        if (cull) glEnable(GL_CULL_FACE);
+    }
+};
+
+#endif
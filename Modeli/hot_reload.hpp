@@ -0,0 +1,176 @@
+#ifndef HOT_RELOAD_H
+#define HOT_RELOAD_H
+
+#include <GL/glew.h>
+
+#include "shader.hpp"
+#include "shader_sources.hpp"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+// Reports files that were written since the last poll.
+// Linux: inotify on the parent directories (editors often save via rename, so
+// IN_MOVED_TO is watched next to IN_CLOSE_WRITE). elsewhere: cheap mtime polling.
+class FileWatcher {
+public:
+    ~FileWatcher()
+    {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    void add(const std::string& file)
+    {
+        std::filesystem::path p = std::filesystem::absolute(file).lexically_normal();
+        for (const Entry& e : files)
+            if (e.path == p) return;
+
+        Entry e;
+        e.path = p;
+        std::error_code ec;
+        e.stamp = std::filesystem::last_write_time(p, ec);
+        files.push_back(e);
+
+#ifdef __linux__
+        if (fd < 0) fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) return;
+        std::filesystem::path dir = p.parent_path();
+        for (const Dir& d : dirs)
+            if (d.path == dir) return;
+        int wd = inotify_add_watch(fd, dir.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) dirs.push_back({ wd, dir });
+#endif
+    }
+
+    // never blocks; returns the watched files that changed
+    std::vector<std::filesystem::path> poll()
+    {
+        std::vector<std::filesystem::path> changed;
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            alignas(inotify_event) char buf[4096];
+            for (;;)
+            {
+                ssize_t n = read(fd, buf, sizeof(buf));
+                if (n <= 0) break;
+                for (char* ptr = buf; ptr < buf + n; )
+                {
+                    const inotify_event* ev = (const inotify_event*)ptr;
+                    ptr += sizeof(inotify_event) + ev->len;
+                    if (ev->len == 0) continue;
+                    for (const Dir& d : dirs)
+                    {
+                        if (d.wd != ev->wd) continue;
+                        std::filesystem::path p = d.path / ev->name;
+                        for (const Entry& e : files)
+                            if (e.path == p) addUnique(changed, p);
+                    }
+                }
+            }
+            return changed;
+        }
+#endif
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastScan < std::chrono::milliseconds(500)) return changed;
+        lastScan = now;
+
+        for (Entry& e : files)
+        {
+            std::error_code ec;
+            auto stamp = std::filesystem::last_write_time(e.path, ec);
+            if (ec || stamp == e.stamp) continue;
+            e.stamp = stamp;
+            addUnique(changed, e.path);
+        }
+        return changed;
+    }
+
+private:
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type stamp;
+    };
+    std::vector<Entry> files;
+    std::chrono::steady_clock::time_point lastScan;
+
+#ifdef __linux__
+    struct Dir {
+        int wd;
+        std::filesystem::path path;
+    };
+    int fd = -1;
+    std::vector<Dir> dirs;
+#endif
+
+    static void addUnique(std::vector<std::filesystem::path>& v, const std::filesystem::path& p)
+    {
+        for (const auto& x : v)
+            if (x == p) return;
+        v.push_back(p);
+    }
+};
+
+// Recompiles registered programs when their sources change, keeping the old one until the new one links.
+// update() is called once per frame before drawing. with KHR/ARB_parallel_shader_compile it never
+// waits on the compiler; without it the swap waits for a fence after the link, which most drivers
+// honour, and a stall that still happens is logged by Shader::pollReload().
+// only active when the sources come from disk (ShaderSources::fromDisk()).
+class ShaderHotReload {
+public:
+    void init()
+    {
+        // let the driver use as many compiler threads as it likes
+        if (GLEW_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        else if (GLEW_ARB_parallel_shader_compile)
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+    }
+
+    void add(Shader& shader)
+    {
+        if (!ShaderSources::fromDisk()) return;
+        shaders.push_back(&shader);
+        watcher.add(ShaderSources::path(shader.vertexFile));
+        watcher.add(ShaderSources::path(shader.fragmentFile));
+    }
+
+    void update()
+    {
+        if (shaders.empty()) return;
+
+        for (const std::filesystem::path& file : watcher.poll())
+        {
+            for (Shader* s : shaders)
+            {
+                if (sameFile(file, s->vertexFile) || sameFile(file, s->fragmentFile))
+                    s->beginReload();
+            }
+        }
+
+        for (Shader* s : shaders)
+            s->pollReload();
+    }
+
+private:
+    FileWatcher watcher;
+    std::vector<Shader*> shaders;
+
+    static bool sameFile(const std::filesystem::path& changed, const std::string& file)
+    {
+        return std::filesystem::absolute(ShaderSources::path(file)).lexically_normal() == changed;
+    }
+};
+
+#endif
@@ -15,6 +15,25 @@
 
 #include "shader.hpp"
 #include "camera.hpp"
+#include "frame_uniforms.hpp"
+#include "object_buffer.hpp"
+#include "hot_reload.hpp"
+#include "shader_variants.hpp"
+#include "culling.hpp"
+#include "occlusion_culler.hpp"
+#include "parallel.hpp"
+#include "gpu_occlusion.hpp"
+#include "cube_batch.hpp"
+#include "static_geometry.hpp"
+#include "water.hpp"
+#include "particles.hpp"
+#include "gpu_droplets.hpp"
+#include "fixed_step.hpp"
+#include "sim_thread.hpp"
+#include "random.hpp"
+#include "thermal.hpp"
+#include "raycast.hpp"
+#include "pick_buffer.hpp"
 
 // STB used for icon textures (fire/snow/ok)
 
@@ -31,9 +50,11 @@ const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
 
 // ===== SIMPLE STATE =====
+// the game state below (up to the droplets) belongs to the simulation thread once it runs;
+// the render thread only sees it through SimSnapshot (see SIMULATION)
 bool  klimaOn = false;
 int   targetTemp = 24;
-float currentTemp = 31.0f;
+float currentTemp = 31.0f;   // room air at the temperature probe (see ROOM AIR)
 
 // lid anim
 float lidT = 0.0f;         // 0..1
@@ -61,6 +82,23 @@ static constexpr float FLOOR_Y = -FLOOR_THICK * 0.5f;
 static constexpr float WALL_Z_BACK = -3.0f;
 static constexpr float WALL_THICK = 0.1f;
 
+// ===== ROOM AIR =====
+// voxel temperature field of the room (thermal.hpp); the AC blows air at a supply temperature
+// set by its thermostat, a PI controller on the sensor in its intake
+const float ROOM_AIR_CELL = 0.125f;          // grid spacing, world units
+const float ROOM_AIR_START = 31.0f;          // room and outside temperature
+const float AC_JET_SPEED = 1.5f;
+const float AC_ROLL_SPEED = 0.4f;            // room circulation driven by the jet
+const float AC_THERMOSTAT_P = 2.0f;
+const float AC_THERMOSTAT_I = 0.3f;          // 1/s
+const float AC_SUPPLY_RANGE = 12.0f;         // supply air within target +- this
+
+ThermalField roomAir;
+ThermalParams roomAirParams;
+float thermostatIntegral = 0.0f;
+bool  probeAtCamera = false;                 // render thread: key 7
+glm::vec3 tempProbe(0.0f);                   // where currentTemp is read (simulation thread)
+
 // ===== BASIN GEOM (mesh-space) =====
 static constexpr float BASIN_H = 0.35f;
 static constexpr float BASIN_R_TOP = 0.55f;
@@ -71,14 +109,14 @@ const float basinScale = 0.85f;
 const float BASIN_EPS = 0.002f;
 
 const float BASIN_PICK_DISTANCE = 3.0f;
-const float BASIN_PICK_RADIUS = 2.0f;
 
 // ===== WATER FILL =====
 float waterLevel = 0.0f;                 // 0..1
 const float waterFillPerHit = 0.004f;    // per droplet impact
 
-unsigned int waterVAO = 0, waterVBO = 0;
-int waterVertexCount = 0;
+WaterSurface water;                       // static mesh shaped in basic.vert + ripple heightfield
+WaterRipples ripples;                     // the heightfield, stepped by the simulation
+unsigned int rippleVersion = 0;           // bumped whenever the heightfield changed
 
 // ===== NAME =====
 unsigned int uiVAO = 0, uiVBO = 0;
@@ -100,17 +138,19 @@ static bool DIGITS[10][7] = {
 };
 
 // ===== DROPLETS =====
-struct Droplet {
-    glm::vec3 pos;
-    glm::vec3 vel;
-    bool alive;
-};
-std::vector<Droplet> droplets;
-
+// quality knob: any count works (see DropletSystem), the fill rate stays the same
 const int   DROPLET_COUNT = 60;
+const int   DROPLET_REFERENCE_COUNT = 60;   // waterFillPerHit is tuned for this many
 const float DROPLET_SIZE = 0.02f;
 const float DROPLET_GRAVITY = 6.5f;
 const float DROPLET_SPAWN_JIT = 0.12f;
+const float DROPLET_RIPPLE_STRENGTH = 0.6f;
+
+DropletSystem droplets;
+ParticleRenderer dropletRenderer;
+GpuDroplets gpuDroplets;           // transform feedback version of the same droplets (opt-in)
+bool useGpuDroplets = false;       // simulation side copy of gpuDroplets.enabled
+unsigned int dropletEpoch = 0;     // bumped when every droplet goes back to the outlet
 
 // ===================== CAMERA =====================
 Camera camera(glm::vec3(0.0f, 1.5f, 0.0f));
@@ -121,21 +161,124 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// ===================== SIMULATION =====================
+// temperature, droplets, water, the lid and the basin run on their own thread in fixed ticks
+// (see fixed_step.hpp, sim_thread.hpp). input reaches it as commands; after every batch of
+// ticks it publishes a snapshot, and each frame draws the newest one, interpolated between
+// its last two ticks. camera and render toggles stay on the render thread.
+const float SIM_TICK_RATE = 120.0f;   // ticks per second
+const int   SIM_MAX_TICKS = 8;        // per batch; after a longer hitch the simulation slows down
+
+// the interpolated part of the state (droplets are interpolated in basic.vert from their velocity)
+struct SimState {
+    float lidT;
+    float waterLevel;
+    float currentTemp;
+};
+
+static SimState captureSim()
+{
+    return { lidT, waterLevel, currentTemp };
+}
+
+static SimState lerpSim(const SimState& a, const SimState& b, float t)
+{
+    return { a.lidT + (b.lidT - a.lidT) * t,
+        a.waterLevel + (b.waterLevel - a.waterLevel) * t,
+        a.currentTemp + (b.currentTemp - a.currentTemp) * t };
+}
+
+// everything the render thread needs from one simulation step, immutable once published
+struct SimSnapshot {
+    SimState previous = {}, current = {};   // the last two ticks
+    SimThread::Clock::time_point tickTime;  // real time of 'current'
+    float tickDt = 0.0f;
+
+    bool klimaOn = false;
+    int  targetTemp = 0;
+    bool basinHeld = false;
+    bool basinFull = false;
+
+    unsigned int dropletEpoch = 0;
+    std::vector<float> dropletX, dropletY, dropletZ, dropletVY;   // CPU droplets, empty while off
+
+    unsigned int rippleVersion = ~0u;
+    std::vector<float> ripples;   // WATER_GRID^2 heights
+};
+
+// input from the render thread
+enum SimCommandType {
+    SIM_TOGGLE_KLIMA,
+    SIM_TEMP_UP,
+    SIM_TEMP_DOWN,
+    SIM_SPACE,          // camera position + front, count = FacingFlags
+    SIM_PICK_BASIN,     // the click ray hit the basin
+    SIM_GPU_DROPLETS,   // count = 1 on, 0 off
+    SIM_IMPACTS,        // GPU droplets landed: count + up to PARTICLE_IMPACT_SAMPLES positions
+    SIM_PROBE           // where to read the room temperature: position
+};
+
+// what SPACE is aimed at, worked out on the render thread (it owns the scene objects)
+enum FacingFlags {
+    FACING_AC = 1,           // looking at the AC: dock the basin
+    FACING_AWAY_FROM_AC = 2  // back to the AC: empty the basin
+};
+
+struct SimCommand {
+    SimCommandType type;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 front = glm::vec3(0.0f);
+    int count = 0;
+    int sampleCount = 0;
+    glm::vec2 samples[PARTICLE_IMPACT_SAMPLES];
+};
+
+SpscQueue<SimCommand, 256> simCommands;
+SnapshotBuffer<SimSnapshot> simSnapshots;
+SimThread simThread;
+
+// simulation thread
+SimState simPrevious = captureSim();
+
+// render thread: the snapshot drawn this frame, its interpolated state and how far
+// (0..1) this frame is past the snapshot's last tick
+const SimSnapshot* frameSim = nullptr;
+SimState shown = {};
+float shownAlpha = 1.0f;
+
+// GPU droplets need the GL context, so they are stepped on the render thread with a clock
+// of their own and only report impacts back
+FixedStep gpuDropletClock(SIM_TICK_RATE, SIM_MAX_TICKS);
+unsigned int gpuDropletEpoch = 0;
+
+static void sendSim(const SimCommand& cmd)
+{
+    if (!simCommands.push(cmd))
+        std::cout << "Simulation command queue full, input dropped" << std::endl;
+}
+
+static void sendSim(SimCommandType type)
+{
+    SimCommand cmd;
+    cmd.type = type;
+    sendSim(cmd);
+}
+
 // ===================== NEW INTERACTION STATE =====================
 static bool basinHeld = false;    
 static bool basinFull = false;    
 static glm::vec3 basinPosDefault(0.0f);
 static glm::vec3 basinPos(0.0f);
 
-static bool pendingSpace = false;
 static bool spaceWasDown = false;
 
 static bool mouseClicked = false;
 static double clickX = 0.0, clickY = 0.0;
 
 // ===================== FORWARD DECLS =====================
-void drawCube();
-void drawBasin();
+void submitCube(const glm::mat4& M, const glm::vec3& color, unsigned int features = 0);
+void submitBasin(const glm::mat4& M, const glm::vec3& color);
+int facingFlags(const glm::vec3& pos, const glm::vec3& front);
 
 // ===================== INPUT =====================
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -178,23 +321,28 @@ void processInput(GLFWwindow* window)
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) camera.ProcessKeyboard(RIGHT, deltaTime);
 
+    // game input goes to the simulation thread (see applySimCommand)
     bool eDown = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
-    if (eDown && !eWasDown) {
-        if (!basinHeld)
-            klimaOn = !klimaOn;
-    }
+    if (eDown && !eWasDown) sendSim(SIM_TOGGLE_KLIMA);
     eWasDown = eDown;
 
     bool upDown = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
-    if (upDown && !upWasDown && klimaOn) targetTemp = std::min(40, targetTemp + 1);
+    if (upDown && !upWasDown) sendSim(SIM_TEMP_UP);
     upWasDown = upDown;
 
     bool dnDown = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
-    if (dnDown && !downWasDown && klimaOn) targetTemp = std::max(-10, targetTemp - 1);
+    if (dnDown && !downWasDown) sendSim(SIM_TEMP_DOWN);
     downWasDown = dnDown;
 
     bool sp = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
-    if (sp && !spaceWasDown) pendingSpace = true;
+    if (sp && !spaceWasDown) {
+        SimCommand cmd;
+        cmd.type = SIM_SPACE;
+        cmd.position = camera.Position;
+        cmd.front = camera.Front;
+        cmd.count = facingFlags(camera.Position, camera.Front);
+        sendSim(cmd);
+    }
     spaceWasDown = sp;
 }
 
@@ -203,6 +351,90 @@ unsigned int cubeVAO = 0, cubeVBO = 0;
 unsigned int basinVAO = 0, basinVBO = 0;
 int basinVertexCount = 0;
 unsigned int quadVAO = 0, quadVBO = 0;
+TriangleBVH cubeBVH, basinBVH;     // the same meshes for ray casting (see PICK SCENE)
+
+// ===================== PER-FRAME DRAW LIST =====================
+// the frame is recorded first and drawn after the object buffer is uploaded once
+struct DrawItem {
+    unsigned int vao;
+    int count;
+    int object;            // record in objectBuffer
+    int bounds;            // sphere in frustumCuller
+    unsigned int features; // BasicFeature bits -> basic shader variant
+};
+
+// an OBJ model placed this frame
+struct ModelItem {
+    int object = -1;
+    int bounds = -1;
+    int query = -1;        // slot in gpuOcclusion, -1 = never queried
+    glm::mat4 M = glm::mat4(1.0f);
+};
+
+// model-space boxes of the procedural meshes
+const glm::vec3 CUBE_MIN(-0.5f), CUBE_MAX(0.5f);
+const glm::vec3 BASIN_MIN(-BASIN_R_TOP, -BASIN_H * 0.5f, -BASIN_R_TOP);
+const glm::vec3 BASIN_MAX(+BASIN_R_TOP, +BASIN_H * 0.5f, +BASIN_R_TOP);
+
+// basic.vert/basic.frag permutation bits, in the order of the ShaderVariants feature list
+enum BasicFeature : unsigned int {
+    BASIC_UNLIT = 1u << 0,    // flat emissive color, skips the lighting entirely
+    BASIC_INSTANCED = 1u << 1,// object index per instance instead of uObjectIndex (CubeBatch)
+    BASIC_WATER = 1u << 2,    // unit water mesh shaped by uniforms + ripple texture (WaterSurface)
+    BASIC_PARTICLE = 1u << 3, // unit cube per droplet, positions from per-instance streams
+    BASIC_PICK = 1u << 4      // pick id instead of color (ID pass, see pick_buffer.hpp)
+};
+
+// variants compiled up front; anything else is compiled the first time it is drawn
+static const uint32_t BASIC_MANIFEST[] = { 0, BASIC_UNLIT, BASIC_INSTANCED, BASIC_UNLIT | BASIC_INSTANCED, BASIC_WATER, BASIC_PARTICLE,
+    BASIC_PICK, BASIC_PICK | BASIC_INSTANCED, BASIC_PICK | BASIC_UNLIT | BASIC_INSTANCED, BASIC_PICK | BASIC_WATER, BASIC_PICK | BASIC_PARTICLE };
+static const uint32_t MODEL_MANIFEST[] = { MESH_DIFFUSE_MAP, MESH_DIFFUSE_MAP | MESH_SPEC_MAP,
+    MESH_PICK | MESH_DIFFUSE_MAP, MESH_PICK | MESH_DIFFUSE_MAP | MESH_SPEC_MAP };
+
+ObjectBuffer objectBuffer;
+std::vector<DrawItem> basicPass;   // flat-colored geometry (basic shader variants)
+CubeBatch cubeBatch;               // every unit cube of the frame, drawn instanced
+StaticGeometry staticScene;        // room + AC body, baked once in world space
+FrustumCuller frustumCuller;       // bounds of everything recorded this frame
+OcclusionCuller occlusionCuller;   // CPU depth buffer of the big boxes (room, AC body)
+GpuOcclusion gpuOcclusion;         // hardware queries for the OBJ models (opt-in)
+RayScene sceneObjects;             // every object of the room in a dynamic AABB tree (see SCENE OBJECTS)
+
+// ids in sceneObjects
+int objAC = -1, objLid = -1, objBasin = -1, objToilet = -1, objRemote = -1, objDroplets = -1, objIcon = -1;
+int objScreens[3] = { -1, -1, -1 };
+
+// clicks resolved by the GPU: object ids rendered under the cursor, read back a frame or two later
+PickBuffer pickBuffer;
+bool idPicking = false;   // key 8; off = CPU ray cast
+
+// pick id of a scene object in the object records (ObjectBuffer::pickId); 0 = nothing
+static uint32_t pickIdOf(int id)
+{
+    return (uint32_t)(id + 1);
+}
+
+// viewFrame of the last frame each scene object was in the frustum (markVisible)
+std::vector<unsigned int> objectSeen;
+unsigned int viewFrame = 0;
+
+// whether to record an object this frame at all
+static bool inView(int id)
+{
+    return !frustumCuller.enabled || objectSeen[id] == viewFrame;
+}
+
+// hashed at compile time; every variant has its own location for it
+constexpr UniformKey U_OBJECT_INDEX("uObjectIndex");
+// the same for the single programs (7-seg readouts, icons, UI)
+constexpr UniformKey U_M("uM");
+constexpr UniformKey U_SIZE("uSize");
+constexpr UniformKey U_SEGMENTS("uSegments");
+constexpr UniformKey U_ON_COLOR("uOnColor");
+constexpr UniformKey U_OFF_COLOR("uOffColor");
+constexpr UniformKey U_TEXTURE("uTexture");
+constexpr UniformKey U_TEX("uTex");
+constexpr UniformKey U_PICK_ID("uPickId");
 
 // ===================== TEXTURES (ICONS) =====================
 unsigned int texFire = 0, texSnow = 0, texOk = 0;
@@ -233,59 +465,61 @@ static unsigned int loadTextureRGBA(const char* path)
     return tex;
 }
 
+// unit cube [-0.5, 0.5], triangle list of position + normal
+static const float CUBE_VERTICES[] = {
+    // positions        // normals
+   -0.5f,-0.5f,-0.5f,   0,0,-1,
+    0.5f,-0.5f,-0.5f,   0,0,-1,
+    0.5f, 0.5f,-0.5f,   0,0,-1,
+    0.5f, 0.5f,-0.5f,   0,0,-1,
+   -0.5f, 0.5f,-0.5f,   0,0,-1,
+   -0.5f,-0.5f,-0.5f,   0,0,-1,
+
+   -0.5f,-0.5f, 0.5f,   0,0,1,
+    0.5f,-0.5f, 0.5f,   0,0,1,
+    0.5f, 0.5f, 0.5f,   0,0,1,
+    0.5f, 0.5f, 0.5f,   0,0,1,
+   -0.5f, 0.5f, 0.5f,   0,0,1,
+   -0.5f,-0.5f, 0.5f,   0,0,1,
+
+   -0.5f, 0.5f, 0.5f,  -1,0,0,
+   -0.5f, 0.5f,-0.5f,  -1,0,0,
+   -0.5f,-0.5f,-0.5f,  -1,0,0,
+   -0.5f,-0.5f,-0.5f,  -1,0,0,
+   -0.5f,-0.5f, 0.5f,  -1,0,0,
+   -0.5f, 0.5f, 0.5f,  -1,0,0,
+
+    0.5f, 0.5f, 0.5f,   1,0,0,
+    0.5f, 0.5f,-0.5f,   1,0,0,
+    0.5f,-0.5f,-0.5f,   1,0,0,
+    0.5f,-0.5f,-0.5f,   1,0,0,
+    0.5f,-0.5f, 0.5f,   1,0,0,
+    0.5f, 0.5f, 0.5f,   1,0,0,
+
+   -0.5f,-0.5f,-0.5f,   0,-1,0,
+    0.5f,-0.5f,-0.5f,   0,-1,0,
+    0.5f,-0.5f, 0.5f,   0,-1,0,
+    0.5f,-0.5f, 0.5f,   0,-1,0,
+   -0.5f,-0.5f, 0.5f,   0,-1,0,
+   -0.5f,-0.5f,-0.5f,   0,-1,0,
+
+   -0.5f, 0.5f,-0.5f,   0,1,0,
+    0.5f, 0.5f,-0.5f,   0,1,0,
+    0.5f, 0.5f, 0.5f,   0,1,0,
+    0.5f, 0.5f, 0.5f,   0,1,0,
+   -0.5f, 0.5f, 0.5f,   0,1,0,
+   -0.5f, 0.5f,-0.5f,   0,1,0
+};
+const int CUBE_VERTEX_COUNT = 36;
+
 void initCube()
 {
-    static const float vertices[] = {
-        // positions        // normals
-       -0.5f,-0.5f,-0.5f,   0,0,-1,
-        0.5f,-0.5f,-0.5f,   0,0,-1,
-        0.5f, 0.5f,-0.5f,   0,0,-1,
-        0.5f, 0.5f,-0.5f,   0,0,-1,
-       -0.5f, 0.5f,-0.5f,   0,0,-1,
-       -0.5f,-0.5f,-0.5f,   0,0,-1,
-
-       -0.5f,-0.5f, 0.5f,   0,0,1,
-        0.5f,-0.5f, 0.5f,   0,0,1,
-        0.5f, 0.5f, 0.5f,   0,0,1,
-        0.5f, 0.5f, 0.5f,   0,0,1,
-       -0.5f, 0.5f, 0.5f,   0,0,1,
-       -0.5f,-0.5f, 0.5f,   0,0,1,
-
-       -0.5f, 0.5f, 0.5f,  -1,0,0,
-       -0.5f, 0.5f,-0.5f,  -1,0,0,
-       -0.5f,-0.5f,-0.5f,  -1,0,0,
-       -0.5f,-0.5f,-0.5f,  -1,0,0,
-       -0.5f,-0.5f, 0.5f,  -1,0,0,
-       -0.5f, 0.5f, 0.5f,  -1,0,0,
-
-        0.5f, 0.5f, 0.5f,   1,0,0,
-        0.5f, 0.5f,-0.5f,   1,0,0,
-        0.5f,-0.5f,-0.5f,   1,0,0,
-        0.5f,-0.5f,-0.5f,   1,0,0,
-        0.5f,-0.5f, 0.5f,   1,0,0,
-        0.5f, 0.5f, 0.5f,   1,0,0,
-
-       -0.5f,-0.5f,-0.5f,   0,-1,0,
-        0.5f,-0.5f,-0.5f,   0,-1,0,
-        0.5f,-0.5f, 0.5f,   0,-1,0,
-        0.5f,-0.5f, 0.5f,   0,-1,0,
-       -0.5f,-0.5f, 0.5f,   0,-1,0,
-       -0.5f,-0.5f,-0.5f,   0,-1,0,
-
-       -0.5f, 0.5f,-0.5f,   0,1,0,
-        0.5f, 0.5f,-0.5f,   0,1,0,
-        0.5f, 0.5f, 0.5f,   0,1,0,
-        0.5f, 0.5f, 0.5f,   0,1,0,
-       -0.5f, 0.5f, 0.5f,   0,1,0,
-       -0.5f, 0.5f,-0.5f,   0,1,0
-    };
-
     glGenVertexArrays(1, &cubeVAO);
     glGenBuffers(1, &cubeVBO);
 
     glBindVertexArray(cubeVAO);
     glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CUBE_VERTICES), CUBE_VERTICES, GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -294,6 +528,8 @@ void initCube()
     glEnableVertexAttribArray(1);
 
     glBindVertexArray(0);
+
+    cubeBVH.build(CUBE_VERTICES, CUBE_VERTEX_COUNT, 6);
 }
 
 static void pushVertex(std::vector<float>& v, const glm::vec3& p, const glm::vec3& n)
@@ -352,6 +588,7 @@ void initBasin(int segments = 48)
     }
 
     basinVertexCount = (int)(verts.size() / 6);
+    basinBVH.build(verts.data(), verts.size() / 6, 6);
 
     glGenVertexArrays(1, &basinVAO);
     glGenBuffers(1, &basinVBO);
@@ -369,86 +606,17 @@ void initBasin(int segments = 48)
     glBindVertexArray(0);
 }
 
-// ===== WATER MESH =====
-static void initWaterMesh()
-{
-    glGenVertexArrays(1, &waterVAO);
-    glGenBuffers(1, &waterVBO);
-
-    glBindVertexArray(waterVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, waterVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 6 * 256, nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
-}
-
-static void updateWaterMesh(int segments, float level, float basinX, float basinY, float basinZ)
+// ===== WATER BODY =====
+// radii + heights of the water in a basin at 'basinY' (see WaterSurface::submit), world units
+static glm::vec4 waterShape(float level, float basinY)
 {
     level = clampf(level, 0.0f, 1.0f);
-    if (level <= 0.0f) { waterVertexCount = 0; return; }
-
-    std::vector<float> v;
-    v.reserve(segments * 12 * 6);
-
     float r0 = BASIN_R_BOT * basinScale * 0.85f;
     float r1 = (BASIN_R_BOT + level * (BASIN_R_TOP - BASIN_R_BOT)) * basinScale * 0.85f;
 
     float yBottomWorld = basinY + basinScale * (-BASIN_H * 0.5f) + 0.006f;
     float yTopWorld = yBottomWorld + (level * basinScale * BASIN_H);
-
-    for (int i = 0; i < segments; i++)
-    {
-        float a0 = (float)i / segments * 2.0f * 3.1415926f;
-        float a1 = (float)(i + 1) / segments * 2.0f * 3.1415926f;
-
-        glm::vec3 p0t = { std::cos(a0) * r1, yTopWorld,    std::sin(a0) * r1 };
-        glm::vec3 p1t = { std::cos(a1) * r1, yTopWorld,    std::sin(a1) * r1 };
-        glm::vec3 p0b = { std::cos(a0) * r0, yBottomWorld, std::sin(a0) * r0 };
-        glm::vec3 p1b = { std::cos(a1) * r0, yBottomWorld, std::sin(a1) * r0 };
-
-        glm::vec3 n0 = glm::normalize(glm::vec3(std::cos(a0), 0.2f, std::sin(a0)));
-        glm::vec3 n1 = glm::normalize(glm::vec3(std::cos(a1), 0.2f, std::sin(a1)));
-
-        auto push = [&](const glm::vec3& p, const glm::vec3& n) {
-            v.push_back(p.x + basinX);
-            v.push_back(p.y);
-            v.push_back(p.z + basinZ);
-            v.push_back(n.x); v.push_back(n.y); v.push_back(n.z);
-            };
-
-        push(p0t, n0); push(p0b, n0); push(p1b, n1);
-        push(p0t, n0); push(p1b, n1); push(p1t, n1);
-    }
-
-    glm::vec3 center = { basinX, yTopWorld, basinZ };
-    glm::vec3 nUp = { 0.0f, 1.0f, 0.0f };
-
-    for (int i = 0; i < segments; i++)
-    {
-        float a0 = (float)i / segments * 2.0f * 3.1415926f;
-        float a1 = (float)(i + 1) / segments * 2.0f * 3.1415926f;
-
-        glm::vec3 p0 = { basinX + std::cos(a0) * r1, yTopWorld, basinZ + std::sin(a0) * r1 };
-        glm::vec3 p1 = { basinX + std::cos(a1) * r1, yTopWorld, basinZ + std::sin(a1) * r1 };
-
-        v.push_back(center.x); v.push_back(center.y); v.push_back(center.z);
-        v.push_back(nUp.x);    v.push_back(nUp.y);    v.push_back(nUp.z);
-
-        v.push_back(p0.x); v.push_back(p0.y); v.push_back(p0.z);
-        v.push_back(nUp.x); v.push_back(nUp.y); v.push_back(nUp.z);
-
-        v.push_back(p1.x); v.push_back(p1.y); v.push_back(p1.z);
-        v.push_back(nUp.x); v.push_back(nUp.y); v.push_back(nUp.z);
-    }
-
-    waterVertexCount = (int)(v.size() / 6);
-    glBindBuffer(GL_ARRAY_BUFFER, waterVBO);
-    glBufferData(GL_ARRAY_BUFFER, v.size() * sizeof(float), v.data(), GL_DYNAMIC_DRAW);
+    return glm::vec4(r0, r1, yBottomWorld, yTopWorld);
 }
 
 // ===== TEXTURED QUAD (icon) =====
@@ -481,22 +649,102 @@ void initTexturedQuad()
 }
 
 // ===== DRAW BASIC =====
-void drawCube()
+// [lo, hi] is the model-space box of the mesh, used for culling
+static void submit(unsigned int vao, int count, const glm::mat4& M, const glm::vec3& color,
+    const glm::vec3& lo, const glm::vec3& hi, unsigned int features = 0)
 {
-    glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    DrawItem item;
+    item.vao = vao;
+    item.count = count;
+    item.object = objectBuffer.push(M, color);
+    item.bounds = frustumCuller.add(M, lo, hi);
+    item.features = features;
+    basicPass.push_back(item);
 }
 
-void drawBasin()
+void submitCube(const glm::mat4& M, const glm::vec3& color, unsigned int features)
 {
-    glBindVertexArray(basinVAO);
-    glDrawArrays(GL_TRIANGLES, 0, basinVertexCount);
+    cubeBatch.add(M, color, features);
+}
+
+void submitBasin(const glm::mat4& M, const glm::vec3& color)
+{
+    submit(basinVAO, basinVertexCount, M, color, BASIN_MIN, BASIN_MAX);
+}
+
+// draws everything recorded for the basic shader that survived culling;
+// expects objectBuffer uploaded + bound
+static void flushBasicPass(ShaderVariants& basicShaders)
+{
+    staticScene.draw(basicShaders, U_OBJECT_INDEX, frustumCuller);
+    cubeBatch.flush(basicShaders, BASIC_INSTANCED);
+
+    Shader* shader = nullptr;
+    unsigned int boundFeatures = 0;
+    unsigned int boundVAO = 0;
+    for (const DrawItem& item : basicPass)
+    {
+        if (!frustumCuller.visible(item.bounds)) continue;
+
+        if (!shader || item.features != boundFeatures) {
+            shader = &basicShaders.get(item.features);
+            shader->use();
+            boundFeatures = item.features;
+        }
+        if (item.vao != boundVAO) {
+            glBindVertexArray(item.vao);
+            boundVAO = item.vao;
+        }
+        shader->setInt(U_OBJECT_INDEX, item.object);
+        glDrawArrays(GL_TRIANGLES, 0, item.count);
+    }
     glBindVertexArray(0);
+
+    water.draw(basicShaders, BASIC_WATER, U_OBJECT_INDEX, frustumCuller);
+    const glm::vec3 dropletSize(DROPLET_SIZE, DROPLET_SIZE * 1.4f, DROPLET_SIZE);
+    const float dropletLag = gpuDroplets.enabled
+        ? gpuDropletClock.step() * (1.0f - gpuDropletClock.alpha())
+        : frameSim->tickDt * (1.0f - shownAlpha);
+    dropletRenderer.draw(basicShaders, BASIC_PARTICLE, U_OBJECT_INDEX, frustumCuller, dropletSize, dropletLag);
+    gpuDroplets.draw(basicShaders, BASIC_PARTICLE, U_OBJECT_INDEX, frustumCuller, dropletSize, dropletLag);
+}
+
+// ===== STATIC SCENE =====
+// room + AC body never move: placed once, baked into world space, drawn per material.
+// they are also the occluders of the CPU occlusion culler
+static int addStaticBox(const glm::vec3& pos, const glm::vec3& scale, const glm::vec3& color, const char* name)
+{
+    glm::mat4 M = glm::translate(glm::mat4(1.0f), pos);
+    M = glm::scale(M, scale);
+    const int id = sceneObjects.add(cubeBVH, M, name);
+    staticScene.add(CUBE_VERTICES, CUBE_VERTEX_COUNT, M, color, 0, true, pickIdOf(id));
+    return id;
+}
+
+static void initStaticScene()
+{
+    const glm::vec3 roomColor(0.8f, 0.8f, 0.8f);
+
+    // floor + ceiling
+    addStaticBox(glm::vec3(0.0f, FLOOR_Y, 0.0f), glm::vec3(6.0f, FLOOR_THICK, 6.0f), roomColor, "room");
+    addStaticBox(glm::vec3(0.0f, 3.0f, 0.0f), glm::vec3(6.0f, 0.1f, 6.0f), roomColor, "room");
+
+    // walls
+    addStaticBox(glm::vec3(-3.0f, 1.5f, 0.0f), glm::vec3(0.1f, 3.0f, 6.0f), roomColor, "room");
+    addStaticBox(glm::vec3(3.0f, 1.5f, 0.0f), glm::vec3(0.1f, 3.0f, 6.0f), roomColor, "room");
+    addStaticBox(glm::vec3(0.0f, 1.5f, -3.0f), glm::vec3(6.0f, 3.0f, 0.1f), roomColor, "room");
+    addStaticBox(glm::vec3(0.0f, 1.5f, 3.0f), glm::vec3(6.0f, 3.0f, 0.1f), roomColor, "room");
+
+    // AC body
+    objAC = addStaticBox(AC_POS, AC_SCALE, glm::vec3(0.55f, 0.55f, 0.55f), "AC");
+
+    staticScene.bake();
+    std::cout << "Static scene: " << staticScene.materialCount() << " materials, "
+        << staticScene.bakedVertices() << " vertices, " << staticScene.bakedIndices() << " indices" << std::endl;
 }
 
 // ===== LID =====
-void drawKlimaLid(Shader& shader)
+static glm::mat4 klimaLidMatrix(float lid)
 {
     const float lidH = 0.08f;
     const float lidHalf = lidH * 0.5f;
@@ -505,112 +753,80 @@ void drawKlimaLid(Shader& shader)
     const float baseY = acBottomY + lidHalf;
 
     const float travelDown = 0.04f;
-    const float y = baseY - travelDown * lidT;
+    const float y = baseY - travelDown * lid;
 
     const float z = AC_FRONT_Z + 0.010f;
 
-    shader.setVec3("uObjectColor", 0.45f, 0.45f, 0.45f);
-
     glm::mat4 M = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, y, z));
     M = glm::scale(M, glm::vec3(AC_SCALE.x * 0.95f, lidH, 0.02f));
-    shader.setMat4("uM", M);
-    drawCube();
+    return M;
+}
+
+void drawKlimaLid(float lid)
+{
+    submitCube(klimaLidMatrix(lid), glm::vec3(0.45f, 0.45f, 0.45f));
 }
 
 // ===================== SCENE HELPERS =====================
-void drawScreen3D(Shader& shader, float x)
+static glm::mat4 screenMatrix(float x)
 {
-    shader.setVec3("uObjectColor", 0.05f, 0.05f, 0.05f);
     glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(x, screenY, screenZ));
     m = glm::scale(m, glm::vec3(screenW, screenH, 0.02f));
-    shader.setMat4("uM", m);
-    drawCube();
+    return m;
 }
 
-static void drawSegment3D(Shader& shader, const glm::vec3& center, const glm::vec3& size, bool on)
+void drawScreen3D(float x)
 {
-    if (on) shader.setVec3("uObjectColor", 0.95f, 0.15f, 0.15f);
-    else    shader.setVec3("uObjectColor", 0.20f, 0.02f, 0.02f);
-
-    glm::mat4 M = glm::translate(glm::mat4(1.0f), center);
-    M = glm::scale(M, size);
-    shader.setMat4("uM", M);
-    drawCube();
+    submitCube(screenMatrix(x), glm::vec3(0.05f, 0.05f, 0.05f));
 }
 
-static void drawDigit3D(Shader& shader, int digit, const glm::vec3& screenCenter)
+static glm::mat4 basinMatrix(const glm::vec3& pos)
 {
-    if (digit < 0 || digit > 9) return;
-
-    const float z = screenZ + 0.0135f;
-    const float w = screenW * 0.40f;
-    const float h = screenH * 0.75f;
-
-    const float segT = screenH * 0.10f;
-    const float segZ = 0.006f;
-
-    const float yTop = +h * 0.50f;
-    const float yMid = 0.0f;
-    const float yBot = -h * 0.50f;
-
-    const float xL = -w * 0.50f;
-    const float xR = +w * 0.50f;
-
-    const float yU = +h * 0.25f;
-    const float yD = -h * 0.25f;
-
-    glm::vec3 horiz = glm::vec3(w, segT, segZ);
-    glm::vec3 vert = glm::vec3(segT, h * 0.50f, segZ);
-
-    bool* s = DIGITS[digit];
-
-    drawSegment3D(shader, glm::vec3(screenCenter.x, screenCenter.y + yTop, z), horiz, s[0]);
-    drawSegment3D(shader, glm::vec3(screenCenter.x + xR, screenCenter.y + yU, z), vert, s[1]);
-    drawSegment3D(shader, glm::vec3(screenCenter.x + xR, screenCenter.y + yD, z), vert, s[2]);
-    drawSegment3D(shader, glm::vec3(screenCenter.x, screenCenter.y + yBot, z), horiz, s[3]);
-    drawSegment3D(shader, glm::vec3(screenCenter.x + xL, screenCenter.y + yD, z), vert, s[4]);
-    drawSegment3D(shader, glm::vec3(screenCenter.x + xL, screenCenter.y + yU, z), vert, s[5]);
-    drawSegment3D(shader, glm::vec3(screenCenter.x, screenCenter.y + yMid, z), horiz, s[6]);
+    glm::mat4 M = glm::translate(glm::mat4(1.0f), pos);
+    M = glm::scale(M, glm::vec3(basinScale));
+    return M;
 }
 
-static void drawNumber2DLike3D(Shader& shader, int value, const glm::vec3& screenCenter)
+// segment mask for segment.frag: ones digit in bits 0-6, tens digit in 7-13,
+// bit 14 = minus sign, bit 15 = tens digit shown
+static int packDisplay(int value)
 {
-    int v = value;
-    bool neg = v < 0;
-    v = std::abs(v);
+    int v = std::abs(value);
     if (v > 99) v = 99;
 
-    int d0 = v / 10;
-    int d1 = v % 10;
-
-    const float z = screenZ + 0.0135f;
-    const float dx = screenW * 0.24f;
-
-    if (neg)
+    int bits = 0;
+    for (int i = 0; i < 7; i++)
     {
-        shader.setVec3("uObjectColor", 0.95f, 0.15f, 0.15f);
-        glm::mat4 M = glm::translate(glm::mat4(1.0f), glm::vec3(screenCenter.x - dx * 1.70f, screenCenter.y, z));
-        M = glm::scale(M, glm::vec3(screenW * 0.12f, screenH * 0.07f, 0.006f));
-        shader.setMat4("uM", M);
-        drawCube();
+        if (DIGITS[v % 10][i]) bits |= 1 << i;
+        if (DIGITS[v / 10][i]) bits |= 1 << (7 + i);
     }
+    if (value < 0) bits |= 1 << 14;
+    if (v >= 10) bits |= 1 << 15;
+    return bits;
+}
 
-    if (v >= 10)
-    {
-        drawDigit3D(shader, d0, glm::vec3(screenCenter.x - dx, screenCenter.y, screenCenter.z));
-        drawDigit3D(shader, d1, glm::vec3(screenCenter.x + dx, screenCenter.y, screenCenter.z));
-    }
-    else
-    {
-        drawDigit3D(shader, d1, screenCenter);
-    }
+// whole readout (up to two digits + sign) as one quad in front of the screen
+static void drawNumberDisplay(Shader& segmentShader, int value, const glm::vec3& screenCenter)
+{
+    glm::mat4 M = glm::translate(glm::mat4(1.0f), glm::vec3(screenCenter.x, screenCenter.y, screenZ + 0.0135f));
+    M = glm::scale(M, glm::vec3(screenW, screenH, 1.0f));
+
+    segmentShader.use();
+    segmentShader.setMat4(U_M, M);
+    segmentShader.setVec2(U_SIZE, screenW, screenH);
+    segmentShader.setInt(U_SEGMENTS, packDisplay(value));
+    segmentShader.setVec3(U_ON_COLOR, 0.95f, 0.15f, 0.15f);
+    segmentShader.setVec3(U_OFF_COLOR, 0.20f, 0.02f, 0.02f);
+
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
 }
 
-static void drawLampCircle(Shader& shader)
+static void drawLampCircle()
 {
    
-    if (klimaOn) shader.setVec3("uObjectColor", 1.0f, 0.03f, 0.03f);
-    else         shader.setVec3("uObjectColor", 0.18f, 0.02f, 0.02f);
+    glm::vec3 color = frameSim->klimaOn ? glm::vec3(1.0f, 0.03f, 0.03f) : glm::vec3(0.18f, 0.02f, 0.02f);
 
     glm::vec3 p(0.45f, 2.56f, AC_FRONT_Z + UI_EPS + 0.002f);
 
@@ -634,35 +850,36 @@ static void drawLampCircle(Shader& shader)
         
         M = glm::scale(M, glm::vec3(2.0f * R, T, Z));
 
-        shader.setMat4("uM", M);
-        drawCube();
+        submitCube(M, color, BASIC_UNLIT);
     }
 }
 
 
 unsigned int pickStatusTex()
 {
-    int cur = (int)std::round(currentTemp);
-    if (!klimaOn) return texOk;
-    if (targetTemp > cur) return texFire;
-    if (targetTemp < cur) return texSnow;
+    int cur = (int)std::round(shown.currentTemp);
+    if (!frameSim->klimaOn) return texOk;
+    if (frameSim->targetTemp > cur) return texFire;
+    if (frameSim->targetTemp < cur) return texSnow;
     return texOk;
 }
 
-void drawStatusIcon(Shader& texShader, const glm::mat4& P, const glm::mat4& V)
+static glm::mat4 statusIconMatrix()
 {
-    if (!klimaOn) return;
-    unsigned int tex = pickStatusTex();
-    if (!tex) return;
-
     glm::mat4 M = glm::translate(glm::mat4(1.0f), glm::vec3(SCREEN_X_RIGHT, screenY, screenZ + 0.0135f));
     M = glm::scale(M, glm::vec3(screenW * 0.65f, screenH * 0.65f, 1.0f));
+    return M;
+}
+
+void drawStatusIcon(Shader& texShader)
+{
+    if (!frameSim->klimaOn) return;
+    unsigned int tex = pickStatusTex();
+    if (!tex) return;
 
     texShader.use();
-    texShader.setMat4("uP", P);
-    texShader.setMat4("uV", V);
-    texShader.setMat4("uM", M);
-    texShader.setInt("uTexture", 0);
+    texShader.setMat4(U_M, statusIconMatrix());
+    texShader.setInt(U_TEXTURE, 0);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, tex);
@@ -673,10 +890,10 @@ void drawStatusIcon(Shader& texShader, const glm::mat4& P, const glm::mat4& V)
 }
 
 // ===================== WATER + DROPLETS =====================
-float basinWaterTopY(float basinY)
+float basinWaterTopY(float level, float basinY)
 {
     float yBottomWorld = basinY + basinScale * (-BASIN_H * 0.5f);
-    return yBottomWorld + (waterLevel * basinScale * BASIN_H);
+    return yBottomWorld + (level * basinScale * BASIN_H);
 }
 
 glm::vec3 outletWorldPos()
@@ -685,71 +902,165 @@ glm::vec3 outletWorldPos()
     return glm::vec3(0.0f, acBottomY - 0.02f, AC_FRONT_Z + 0.02f);
 }
 
-static float rand01() { return (float)std::rand() / (float)RAND_MAX; }
-
-void spawnDroplet(Droplet& d)
+// simulation thread; the render thread respawns the GPU droplets when it sees the new epoch
+void initDroplets()
 {
-    glm::vec3 o = outletWorldPos();
-    float jx = (rand01() * 2.0f - 1.0f) * DROPLET_SPAWN_JIT;
-    float jz = (rand01() * 2.0f - 1.0f) * DROPLET_SPAWN_JIT;
-
-    d.pos = o + glm::vec3(jx, 0.0f, jz);
-    d.vel = glm::vec3(0.0f, -0.2f - rand01() * 0.3f, 0.0f);
-    d.alive = true;
+    droplets.respawnAll();
+    dropletEpoch++;
 }
 
-void initDroplets()
+// the droplets' emitter + basin at water level 'level'
+static DropletParams dropletParams(float level, float basinY, float basinZ)
 {
-    droplets.resize(DROPLET_COUNT);
-    for (auto& d : droplets) spawnDroplet(d);
+    DropletParams p;
+    p.origin = outletWorldPos();
+    p.jitter = DROPLET_SPAWN_JIT;
+    p.gravity = DROPLET_GRAVITY;
+    p.captureY = basinWaterTopY(level, basinY);
+    p.captureCenter = glm::vec2(0.0f, basinZ);
+    p.captureRadius = basinScale * BASIN_R_TOP * 0.85f;
+    p.killY = -1.0f;
+    return p;
 }
 
-void updateDroplets(float dt, float basinY, float basinZ)
+// simulation thread: ripples + fill for 'count' landed droplets, 'samples' (x, z) of some of them
+void applyImpacts(int count, const glm::vec2* samples, int sampleCount, float basinY, float basinZ)
 {
-    if (!klimaOn) return;
+    if (count == 0) return;
 
-    float surfaceY = basinWaterTopY(basinY);
-    glm::vec3 basinC(0.0f, basinY, basinZ);
+    // ripples where some of them landed (unit disc of the current surface)
+    float surfaceR = waterShape(waterLevel, basinY).y;
+    if (surfaceR > 0.0f)
+    {
+        for (int i = 0; i < sampleCount; i++)
+        {
+            glm::vec2 dxz(samples[i].x, samples[i].y - basinZ);
+            ripples.impact(dxz / std::max(surfaceR, glm::length(dxz)), DROPLET_RIPPLE_STRENGTH);
+        }
+    }
 
-    float captureR = basinScale * BASIN_R_TOP * 0.85f;
+    // the fill rate doesn't depend on how many droplets there are
+    float perHit = waterFillPerHit * (float)DROPLET_REFERENCE_COUNT / (float)droplets.size();
+    waterLevel = std::min(1.0f, waterLevel + count * perHit);
+}
 
-    for (auto& d : droplets)
-    {
-        if (!d.alive) { spawnDroplet(d); continue; }
+// simulation thread; GPU droplets are stepped by stepGpuDroplets instead
+void updateDroplets(float dt, float basinY, float basinZ, ThreadPool& workers)
+{
+    if (!klimaOn || useGpuDroplets) return;
 
-        d.vel.y -= DROPLET_GRAVITY * dt;
-        d.pos += d.vel * dt;
+    DropletImpacts impacts = droplets.update(dt, dropletParams(waterLevel, basinY, basinZ), workers);
+    applyImpacts(impacts.count, impacts.samples.data(), (int)impacts.samples.size(), basinY, basinZ);
+}
+
+// render thread: the GPU droplets' ticks of this frame, impacts sent to the simulation
+void stepGpuDroplets(float frameTime, float basinY, float basinZ)
+{
+    const int ticks = gpuDropletClock.advance(frameTime);
+    if (frameSim->dropletEpoch != gpuDropletEpoch) {
+        gpuDropletEpoch = frameSim->dropletEpoch;
+        gpuDroplets.respawnAll();
+    }
+    if (!gpuDroplets.enabled || !frameSim->klimaOn) return;
 
-        glm::vec2 dxz(d.pos.x - basinC.x, d.pos.z - basinC.z);
-        float dist2 = dxz.x * dxz.x + dxz.y * dxz.y;
+    DropletParams params = dropletParams(frameSim->current.waterLevel, basinY, basinZ);
+    for (int i = 0; i < ticks; i++)
+    {
+        DropletImpacts impacts = gpuDroplets.step(gpuDropletClock.step(), params);
+        if (impacts.count == 0) continue;
+
+        SimCommand cmd;
+        cmd.type = SIM_IMPACTS;
+        cmd.count = impacts.count;
+        cmd.sampleCount = std::min((int)impacts.samples.size(), PARTICLE_IMPACT_SAMPLES);
+        std::copy(impacts.samples.begin(), impacts.samples.begin() + cmd.sampleCount, cmd.samples);
+        sendSim(cmd);
+    }
+}
 
-        if (d.pos.y <= surfaceY && dist2 <= captureR * captureR)
-        {
-            waterLevel = std::min(1.0f, waterLevel + waterFillPerHit);
-            spawnDroplet(d);
-            continue;
-        }
+// every droplet stays between the outlet and the kill plane, inside the spawn jitter
+static void dropletBounds(float level, float basinY, float basinZ, glm::vec3& lo, glm::vec3& hi)
+{
+    DropletParams p = dropletParams(level, basinY, basinZ);
+    lo = glm::vec3(p.origin.x - p.jitter - DROPLET_SIZE, p.killY - DROPLET_SIZE, p.origin.z - p.jitter - DROPLET_SIZE);
+    hi = glm::vec3(p.origin.x + p.jitter + DROPLET_SIZE, p.origin.y + DROPLET_SIZE, p.origin.z + p.jitter + DROPLET_SIZE);
+}
 
-        if (d.pos.y < -1.0f) {
-            spawnDroplet(d);
-            continue;
-        }
+// render thread
+void drawDroplets(float basinY, float basinZ)
+{
+    dropletRenderer.hide();
+    gpuDroplets.hide();
+    if (!frameSim->klimaOn || !inView(objDroplets)) return;
+
+    glm::vec3 lo, hi;
+    dropletBounds(shown.waterLevel, basinY, basinZ, lo, hi);
+    const glm::vec3 color(0.75f, 0.90f, 1.0f);
+    if (gpuDroplets.enabled) {
+        gpuDroplets.submit(objectBuffer, frustumCuller, color, lo, hi);
+    }
+    else if (!frameSim->dropletX.empty()) {
+        const float* streams[4] = { frameSim->dropletX.data(), frameSim->dropletY.data(), frameSim->dropletZ.data(), frameSim->dropletVY.data() };
+        dropletRenderer.submit(frameSim->dropletX.size(), streams, objectBuffer, frustumCuller, color, lo, hi);
     }
 }
 
-void drawDroplets(Shader& shader)
+// ===================== ROOM AIR =====================
+// the AC's own sensor, in the intake on top of the body
+glm::vec3 acSensorPos()
 {
-    if (!klimaOn) return;
+    return glm::vec3(AC_POS.x, AC_POS.y + AC_SCALE.y * 0.5f + 0.10f, AC_POS.z);
+}
 
-    shader.setVec3("uObjectColor", 0.75f, 0.90f, 1.0f);
+void initRoomAir()
+{
+    // inside the walls, floor and ceiling of initStaticScene
+    const float half = 3.0f - WALL_THICK * 0.5f;
+    roomAir.init(glm::vec3(-half, FLOOR_Y + FLOOR_THICK * 0.5f, WALL_Z_BACK + WALL_THICK * 0.5f),
+        glm::vec3(half, 3.0f - 0.05f, half), ROOM_AIR_CELL, ROOM_AIR_START);
+    roomAir.setOutlet(outletWorldPos(), glm::vec3(0.0f, -0.5f, 1.0f), AC_JET_SPEED, AC_ROLL_SPEED, 0.35f);
+    roomAirParams.ambient = ROOM_AIR_START;
+    thermostatIntegral = 0.0f;
+    tempProbe = acSensorPos();
+    currentTemp = roomAir.sample(tempProbe);
+}
 
-    for (const auto& d : droplets)
-    {
-        glm::mat4 M = glm::translate(glm::mat4(1.0f), d.pos);
-        M = glm::scale(M, glm::vec3(DROPLET_SIZE, DROPLET_SIZE * 1.4f, DROPLET_SIZE));
-        shader.setMat4("uM", M);
-        drawCube();
+// simulation thread
+void updateRoomAir(float dt, ThreadPool& workers)
+{
+    float supply = 0.0f;
+    if (klimaOn) {
+        const float target = (float)targetTemp;
+        const float error = target - roomAir.sample(acSensorPos());
+        thermostatIntegral = clampf(thermostatIntegral + error * AC_THERMOSTAT_I * dt, -AC_SUPPLY_RANGE, AC_SUPPLY_RANGE);
+        supply = clampf(target + AC_THERMOSTAT_P * error + thermostatIntegral, target - AC_SUPPLY_RANGE, target + AC_SUPPLY_RANGE);
     }
+    roomAir.step(dt, klimaOn ? 1.0f : 0.0f, supply, roomAirParams, &workers);
+    currentTemp = roomAir.sample(tempProbe);
+}
+
+// one fixed simulation step (simulation thread)
+void simulateTick(float dt, float basinY, float basinZ, ThreadPool& workers)
+{
+    // room air: heat carried by the AC's flow, diffusing, leaking through the walls
+    updateRoomAir(dt, workers);
+
+    // droplets fill
+    updateDroplets(dt, basinY, basinZ, workers);
+    if (ripples.update(dt)) rippleVersion++;
+
+    // auto-off when full
+    if (waterLevel >= 1.0f) {
+        waterLevel = 1.0f;
+        klimaOn = false;
+        basinFull = true;
+    }
+
+    // lid animation
+    float targetLid = klimaOn ? 1.0f : 0.0f;
+    float step = LID_SPEED * dt;
+    if (lidT < targetLid) lidT = std::min(targetLid, lidT + step);
+    else                  lidT = std::max(targetLid, lidT - step);
 }
 
 // ===================== PICKING + ANGLE CHECK =====================
@@ -766,32 +1077,6 @@ static glm::vec3 screenRayDir(double mx, double my, int w, int h, const glm::mat
     return rayWorld;
 }
 
-static bool raySphereHitDist(
-    const glm::vec3& ro,
-    const glm::vec3& rd,
-    const glm::vec3& c,
-    float r,
-    float& outT
-) {
-    glm::vec3 oc = ro - c;
-
-    float b = glm::dot(oc, rd);
-    float c2 = glm::dot(oc, oc) - r * r;
-    float h = b * b - c2;
-    if (h < 0.0f) return false;
-
-    float s = std::sqrt(h);
-
-    float t0 = -b - s;
-    float t1 = -b + s;
-
-    float t = (t0 > 0.0f) ? t0 : t1;
-    if (t <= 0.0f) return false;
-
-    outT = t;
-    return true;
-}
-
 static float angleDegXZ(const glm::vec3& a, const glm::vec3& b)
 {
     glm::vec2 aa(a.x, a.z);
@@ -805,42 +1090,164 @@ static float angleDegXZ(const glm::vec3& a, const glm::vec3& b)
     return glm::degrees(std::acos(d));
 }
 
+// ===================== SIMULATION THREAD =====================
+static void applySimCommand(const SimCommand& cmd, float basinY, float basinZ)
+{
+    switch (cmd.type)
+    {
+    case SIM_TOGGLE_KLIMA:
+        if (!basinHeld)
+            klimaOn = !klimaOn;
+        break;
+
+    case SIM_TEMP_UP:
+        if (klimaOn) targetTemp = std::min(40, targetTemp + 1);
+        break;
+
+    case SIM_TEMP_DOWN:
+        if (klimaOn) targetTemp = std::max(-10, targetTemp - 1);
+        break;
+
+    case SIM_PICK_BASIN:
+        if (basinFull && !basinHeld)
+            basinHeld = true;
+        break;
+
+    case SIM_SPACE:
+        if (basinHeld) {
+            if (basinFull && (cmd.count & FACING_AWAY_FROM_AC)) {
+                waterLevel = 0.0f;
+                ripples.reset();
+                basinFull = false;
+                simPrevious = captureSim();   // a jump, not something to interpolate
+            }
+            else if (!basinFull && (cmd.count & FACING_AC)) {
+                basinHeld = false;
+
+                klimaOn = false;
+                targetTemp = 24;
+                roomAir.reset(ROOM_AIR_START);
+                thermostatIntegral = 0.0f;
+                currentTemp = roomAir.sample(tempProbe);
+                lidT = 0.0f;
+                simPrevious = captureSim();
+
+                initDroplets();
+            }
+        }
+        break;
+
+    case SIM_GPU_DROPLETS:
+        // the two simulations don't share state: start the new one from the outlet
+        useGpuDroplets = cmd.count != 0;
+        initDroplets();
+        break;
+
+    case SIM_IMPACTS:
+        if (klimaOn)
+            applyImpacts(cmd.count, cmd.samples, cmd.sampleCount, basinY, basinZ);
+        break;
+
+    case SIM_PROBE:
+        tempProbe = cmd.position;
+        break;
+    }
+}
+
+// copies the state into the free snapshot and hands it to the render thread
+static void publishSimulation(SimThread::Clock::time_point tickTime, float dt)
+{
+    SimSnapshot& snap = simSnapshots.back();
+    snap.previous = simPrevious;
+    snap.current = captureSim();
+    snap.tickTime = tickTime;
+    snap.tickDt = dt;
+
+    snap.klimaOn = klimaOn;
+    snap.targetTemp = targetTemp;
+    snap.basinHeld = basinHeld;
+    snap.basinFull = basinFull;
+
+    snap.dropletEpoch = dropletEpoch;
+    if (klimaOn && !useGpuDroplets) {
+        const size_t n = droplets.size();
+        snap.dropletX.assign(droplets.x(), droplets.x() + n);
+        snap.dropletY.assign(droplets.y(), droplets.y() + n);
+        snap.dropletZ.assign(droplets.z(), droplets.z() + n);
+        snap.dropletVY.assign(droplets.velocityY(), droplets.velocityY() + n);
+    }
+    else {
+        snap.dropletX.clear();
+        snap.dropletY.clear();
+        snap.dropletZ.clear();
+        snap.dropletVY.clear();
+    }
+
+    // the slot may be two versions behind; the heightfield is only copied when it moved
+    if (snap.rippleVersion != rippleVersion) {
+        snap.ripples.assign(ripples.heights(), ripples.heights() + WATER_GRID * WATER_GRID);
+        snap.rippleVersion = rippleVersion;
+    }
+
+    simSnapshots.publish();
+}
+
+// one wake-up of the simulation thread: input, the ticks that are due, a new snapshot
+static void runSimulation(int ticks, float dt, SimThread::Clock::time_point tickTime,
+    float basinY, float basinZ, ThreadPool& workers)
+{
+    bool changed = ticks > 0;
+    SimCommand cmd;
+    while (simCommands.pop(cmd)) {
+        applySimCommand(cmd, basinY, basinZ);
+        changed = true;
+    }
+
+    for (int i = 0; i < ticks; i++)
+    {
+        simPrevious = captureSim();
+        simulateTick(dt, basinY, basinZ, workers);
+    }
+
+    if (changed)
+        publishSimulation(tickTime, dt);
+}
+
 // ===================== MODEL DRAW HELPERS =====================
-static void applyModelCommonUniforms(Shader& sh, const glm::mat4& P, const glm::mat4& V)
+static ModelItem submitModel(const Model& model, const glm::mat4& M, int query = -1)
 {
-    sh.use();
-    sh.setMat4("uP", P);
-    sh.setMat4("uV", V);
-    sh.setVec3("uLightPos", 2.0f, 4.0f, 2.0f);
-    sh.setVec3("uViewPos", camera.Position);
-    sh.setVec3("uLightColor", 1.0f, 1.0f, 1.0f);
+    ModelItem item;
+    item.object = objectBuffer.push(M, glm::vec3(1.0f));
+    item.bounds = frustumCuller.add(M, model.boundsMin, model.boundsMax);
+    item.query = query;
+    item.M = M;
+    return item;
 }
 
-static void drawToiletModel(Model& toilet, Shader& modelShader)
+static glm::mat4 toiletModelMatrix()
 {
     glm::mat4 M = glm::mat4(1.0f);
     M = glm::translate(M, glm::vec3(0.0f, 0.0f, 2.25f));
     M = glm::rotate(M, glm::radians(180.0f), glm::vec3(0, 1, 0));
     M = glm::scale(M, glm::vec3(1.0f)); // tune
 
-    modelShader.setMat4("uM", M);
-    toilet.Draw(modelShader);
+    return M;
 }
 
-static void drawRemoteModel(Model& remoteM, Shader& modelShader)
+static glm::mat4 remoteModelMatrix()
 {
    
     glm::vec3 viewOffset(
-        +0.35f,   // 
-        -0.45f,   // 
-        -1.25f    //   
+        +0.35f,   // вправо
+        -0.45f,   // вниз
+        -1.25f    // от камеры вперёд
     );
 
-    // view  inverse view
+    // view и inverse view
     glm::mat4 V = camera.GetViewMatrix();
     glm::mat4 invV = glm::inverse(V);
 
-    //   view-space
+    // модель в view-space
     glm::mat4 M(1.0f);
     M = glm::translate(M, viewOffset);
 
@@ -849,16 +1256,126 @@ static void drawRemoteModel(Model& remoteM, Shader& modelShader)
     M = glm::rotate(M, glm::radians(90.0f), glm::vec3(0, 1, 0));
 
 
-    // 
+    // масштаб
     M = glm::scale(M, glm::vec3(0.05f));
 
-    //    world-space
+    // переводим обратно в world-space
     M = invV * M;
 
-    modelShader.setMat4("uM", M);
-    remoteM.Draw(modelShader);
+    return M;
+}
+
+// every mesh is drawn with the cheapest model.frag variant for its textures
+static void drawModel(Model& model, ShaderVariants& modelShaders, const ModelItem& item)
+{
+    if (item.object < 0 || !frustumCuller.visible(item.bounds)) return;
+
+    gpuOcclusion.draw(item.query, item.M, model.boundsMin, model.boundsMax, camera.Position, [&] {
+        Shader* bound = nullptr;
+        for (Mesh& mesh : model.meshes)
+        {
+            Shader& sh = modelShaders.get(mesh.features);
+            if (&sh != bound) {
+                sh.use();
+                sh.setInt(U_OBJECT_INDEX, item.object);
+                bound = &sh;
+            }
+            mesh.Draw(sh);
+        }
+    });
+}
+
+// ===================== SCENE OBJECTS =====================
+// every object of the room is a box in one dynamic AABB tree (aabb_tree.hpp, via RayScene).
+// what moves is refit in place every frame; frustum culling, click rays and SPACE's "is the
+// AC over there" all ask the tree instead of walking everything. click rays then go down to
+// the triangles: one BVH per mesh, built at load time, the cube BVH serves the whole room.
+const float FACING_TOLERANCE = 35.0f;   // degrees off the line to the AC that still count
+const float FACING_REACH = 8.5f;        // how far the AC may be (the whole room)
+
+// all meshes of a model in one BVH; triangle ids run on from mesh to mesh
+static void buildModelBVH(TriangleBVH& bvh, const Model& model)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    for (const Mesh& mesh : model.meshes)
+    {
+        const uint32_t base = (uint32_t)positions.size();
+        for (const Vertex& v : mesh.vertices) positions.push_back(v.Position);
+        for (unsigned int i : mesh.indices) indices.push_back(base + i);
+    }
+    bvh.build(positions.data(), indices.data(), indices.size() / 3);
+}
+
+// the unit box [-0.5, 0.5] stretched over [lo, hi]
+static glm::mat4 boxMatrix(const glm::vec3& lo, const glm::vec3& hi)
+{
+    glm::mat4 M = glm::translate(glm::mat4(1.0f), (lo + hi) * 0.5f);
+    return glm::scale(M, hi - lo);
+}
+
+// room + AC body are added by initStaticScene; the meshes must outlive sceneObjects
+static void initSceneObjects(const TriangleBVH& toiletBVH, const TriangleBVH& remoteBVH, float basinY, float basinZ)
+{
+    objScreens[0] = sceneObjects.add(cubeBVH, screenMatrix(SCREEN_X_LEFT), "screen");
+    objScreens[1] = sceneObjects.add(cubeBVH, screenMatrix(SCREEN_X_MID), "screen");
+    objScreens[2] = sceneObjects.add(cubeBVH, screenMatrix(SCREEN_X_RIGHT), "screen");
+    objLid = sceneObjects.add(cubeBVH, klimaLidMatrix(0.0f), "AC lid");
+    objBasin = sceneObjects.add(basinBVH, basinMatrix(basinPosDefault), "basin");
+    objToilet = sceneObjects.add(toiletBVH, toiletModelMatrix(), "toilet");
+    objRemote = sceneObjects.add(remoteBVH, remoteModelMatrix(), "remote");
+
+    // bounds only: culled as a whole, never picked
+    glm::vec3 lo, hi;
+    dropletBounds(0.0f, basinY, basinZ, lo, hi);
+    objDroplets = sceneObjects.addBounds(boxMatrix(lo, hi), "droplets");
+    objIcon = sceneObjects.addBounds(glm::scale(statusIconMatrix(), glm::vec3(1.0f, 1.0f, 0.01f)), "status icon");
+    objectSeen.assign(sceneObjects.size(), 0);
+}
+
+// moves what moves to where this frame draws it; the tree only refits leaves that left their fat box
+static void updateSceneObjects(float lid, bool remoteShown, bool acRunning, float level, float basinY, float basinZ)
+{
+    sceneObjects.setTransform(objLid, klimaLidMatrix(lid));
+    sceneObjects.setTransform(objBasin, basinMatrix(basinPos));
+    sceneObjects.setEnabled(objRemote, remoteShown);
+    if (remoteShown)
+        sceneObjects.setTransform(objRemote, remoteModelMatrix());
+
+    sceneObjects.setEnabled(objIcon, acRunning);
+    sceneObjects.setEnabled(objDroplets, acRunning);
+    if (acRunning) {
+        glm::vec3 lo, hi;
+        dropletBounds(level, basinY, basinZ, lo, hi);
+        sceneObjects.setTransform(objDroplets, boxMatrix(lo, hi));
+    }
+}
+
+// one walk down the tree marks every object this frame may see
+static void markVisible(const Frustum& frustum)
+{
+    viewFrame++;
+    sceneObjects.queryFrustum(frustum, [](int id) { objectSeen[id] = viewFrame; });
+}
 
+// SPACE: the AC among the objects near the camera, and which way it lies
+int facingFlags(const glm::vec3& pos, const glm::vec3& front)
+{
+    int flags = 0;
+    sceneObjects.querySphere(pos, FACING_REACH, [&](int id) {
+        if (id != objAC) return;
+        glm::vec3 toAC = sceneObjects.bounds(id).center() - pos;
+        if (angleDegXZ(front, toAC) <= FACING_TOLERANCE) flags |= FACING_AC;
+        if (angleDegXZ(front, -toAC) <= FACING_TOLERANCE) flags |= FACING_AWAY_FROM_AC;
+    });
+    return flags;
+}
 
+// a click found 'id' t meters away, by either picking mode: the basin is picked when full and not held
+static void clickedObject(int id, float t)
+{
+    if (id == objBasin && t < BASIN_PICK_DISTANCE && frameSim->basinFull && !frameSim->basinHeld)
+        sendSim(SIM_PICK_BASIN);
 }
 
 static void initNameQuad_TopLeft(float wNdc = 0.60f, float hNdc = 0.18f, float margin = 0.03f)
@@ -904,7 +1421,7 @@ static void drawNameUI(Shader& uiShader)
     glDisable(GL_DEPTH_TEST);
 
     uiShader.use();
-    uiShader.setInt("uTex", 0);
+    uiShader.setInt(U_TEX, 0);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, uiNameTex);
@@ -923,10 +1440,48 @@ static void drawNameUI(Shader& uiShader)
 
 
 
+// ===================== STATS =====================
+// culling counters on the console, only when they changed and at most twice a second
+static void reportCullStats(float now)
+{
+    static CullStats last;
+    static GpuOcclusionStats lastGpu;
+    static float lastTime = -1.0f;
+
+    const CullStats& s = frustumCuller.frameStats();
+    const GpuOcclusionStats& g = gpuOcclusion.frameStats();
+    if (s.tested == last.tested && s.culled == last.culled && s.occluded == last.occluded &&
+        g.occluded == lastGpu.occluded) return;
+    if (now - lastTime < 0.5f) return;
+
+    std::cout << "Culling: tested " << s.tested << ", culled " << s.culled << ", occluded " << s.occluded
+        << ", drawn " << s.drawn;
+    if (gpuOcclusion.enabled)
+        std::cout << " | GPU queries " << g.queries << ", hidden models " << g.occluded;
+    std::cout << std::endl;
+    last = s;
+    lastGpu = g;
+    lastTime = now;
+}
+
 // ===================== MAIN =====================
-int main()
+int main(int argc, char** argv)
 {
-    std::srand(1337);
+    // --bench particles: droplet update timings, no window
+    if (argc >= 3 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "particles") {
+        runParticleBenchmark();
+        return 0;
+    }
+    // --bench thermal: room air stencil throughput, no window
+    if (argc >= 3 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "thermal") {
+        runThermalBenchmark();
+        return 0;
+    }
+    // --bench raycast: BVH build + pick ray cost on large meshes, no window
+    if (argc >= 3 && std::string(argv[1]) == "--bench" && std::string(argv[2]) == "raycast") {
+        runRaycastBenchmark();
+        return 0;
+    }
 
     if (!glfwInit()) return -1;
 
@@ -959,15 +1514,79 @@ int main()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    Shader shader("basic.vert", "basic.frag");       // cubes
-    Shader texShader("tex.vert", "tex.frag");        // icons
-    Shader modelShader("model.vert", "model.frag");  // obj+mtl
-    Shader uiShader("ui.vert", "ui.frag");
+    // camera + light block shared by the lit programs
+    FrameUniforms frameUniforms;
+    frameUniforms.init();
 
+    // per-object records (model matrix + color), one upload per frame
+    objectBuffer.init();
+
+    // worker threads for the CPU-side passes (occlusion raster, ...)
+    ThreadPool workers;
+
+    // edit a .vert/.frag while running: recompiled and swapped in after linking
+    ShaderHotReload hotReload;
+    hotReload.init();
+
+    auto setupObjectProgram = [&](Shader& s) {
+        frameUniforms.attach(s);
+        objectBuffer.attach(s);
+        hotReload.add(s);
+    };
+
+    ShaderVariants basicShaders("basic.vert", "basic.frag", { "UNLIT", "INSTANCED", "WATER", "PARTICLE", "PICK" });                  // cubes
+    ShaderVariants modelShaders("model.vert", "model.frag", { "DIFFUSE_MAP", "SPEC_MAP", "PICK" }); // obj+mtl
+    basicShaders.onCreate = setupObjectProgram;
+    modelShaders.onCreate = setupObjectProgram;
+
+    // every startup program is queued first and collected once, so the driver can
+    // compile them in parallel; prints total + per-program compile time
+    ShaderBatch startupShaders;
+    basicShaders.precompile(BASIC_MANIFEST, sizeof(BASIC_MANIFEST) / sizeof(BASIC_MANIFEST[0]), startupShaders);
+    modelShaders.precompile(MODEL_MANIFEST, sizeof(MODEL_MANIFEST) / sizeof(MODEL_MANIFEST[0]), startupShaders);
+
+    Shader texShader("tex.vert", "tex.frag", "", true);  // icons
+    Shader texPickShader("tex.vert", "tex.frag", "#define PICK\n", true);  // icons in the ID pass
+    Shader uiShader("ui.vert", "ui.frag", "", true);
+    Shader boundsShader("bounds.vert", "bounds.frag", "", true);  // occlusion query boxes
+    Shader segmentShader("segment.vert", "segment.frag", "", true);  // 7-seg readouts
+    Shader dropletUpdateShader("droplets_update.vert", "droplets.frag", "", true, { "tfState", "tfSeed", "tfHit" });
+    Shader dropletCountShader("droplets_count.vert", "droplets.frag", "", true);
+    startupShaders.add(texShader);
+    startupShaders.add(texPickShader);
+    startupShaders.add(uiShader);
+    startupShaders.add(boundsShader);
+    startupShaders.add(segmentShader);
+    startupShaders.add(dropletUpdateShader);
+    startupShaders.add(dropletCountShader);
+    frameUniforms.attach(texShader);
+    frameUniforms.attach(texPickShader);
+    frameUniforms.attach(boundsShader);
+    frameUniforms.attach(segmentShader);
+    hotReload.add(texShader);
+    hotReload.add(texPickShader);
+    hotReload.add(uiShader);
+    hotReload.add(boundsShader);
+    hotReload.add(segmentShader);
+    hotReload.add(dropletUpdateShader);
+    hotReload.add(dropletCountShader);
+
+    startupShaders.finish();
+    // a missing or broken program would only show up as things silently not being drawn
+    for (const Shader* s : { &texShader, &texPickShader, &uiShader, &boundsShader, &segmentShader, &dropletUpdateShader, &dropletCountShader })
+    {
+        if (!s->valid()) { std::cout << "Shader failed: " << s->vertexFile << " + " << s->fragmentFile << "\n"; glfwTerminate(); return -1; }
+    }
+    if (!basicShaders.valid() || !modelShaders.valid()) { std::cout << "Shader variants failed\n"; glfwTerminate(); return -1; }
 
     initCube();
+    cubeBatch.init(cubeVBO, objectBuffer, frustumCuller);
+    initStaticScene();
+    gpuOcclusion.init(boundsShader, cubeVAO);
+    pickBuffer.init();
     initBasin();
-    initWaterMesh();
+    water.init();
+    dropletRenderer.init(cubeVBO);
     initTexturedQuad();
 
     texFire = loadTextureRGBA("res/fire.png");
@@ -979,6 +1598,8 @@ int main()
     // Load Models
     Model toilet("res/Toilet/Toilet.obj");
     Model remoteM("res/RemoteController/remote_controller.obj");
+    // the remote hangs in front of the camera, it can never be hidden
+    const int toiletQuery = gpuOcclusion.track();
 
     // basin placement
     const float basinBottomLocal = -BASIN_H * 0.5f;
@@ -993,7 +1614,36 @@ int main()
     basinPosDefault = glm::vec3(0.0f, basinY, basinZ);
     basinPos = basinPosDefault;
 
+    // ray casting: a BVH per mesh, every placement an instance
+    TriangleBVH toiletBVH, remoteBVH;
+    buildModelBVH(toiletBVH, toilet);
+    buildModelBVH(remoteBVH, remoteM);
+    initSceneObjects(toiletBVH, remoteBVH, basinY, basinZ);
+    std::cout << "Scene objects: " << sceneObjects.size() << " in a tree of height " << sceneObjects.objects().height()
+        << ", toilet " << toiletBVH.triangleCount() << " + remote " << remoteBVH.triangleCount() << " triangles" << std::endl;
+
+    droplets.init(DROPLET_COUNT, RANDOM_SEED);
+    gpuDroplets.init(dropletUpdateShader, dropletCountShader, cubeVBO, DROPLET_COUNT, RANDOM_SEED, SIM_MAX_TICKS);
     initDroplets();
+    initRoomAir();
+
+    // the simulation gets its own workers: ThreadPool runs one loop at a time, and the
+    // render thread's pool is busy with the occlusion raster while the simulation ticks
+    ThreadPool simWorkers(std::max(1u, std::thread::hardware_concurrency() / 4));
+
+    publishSimulation(SimThread::Clock::now(), 1.0f / SIM_TICK_RATE);
+    simSnapshots.acquire();
+    frameSim = &simSnapshots.front();
+    unsigned int uploadedRippleVersion = frameSim->rippleVersion;
+
+    simThread.start(FixedStep(SIM_TICK_RATE, SIM_MAX_TICKS),
+        [&](int ticks, float dt, SimThread::Clock::time_point tickTime) {
+            runSimulation(ticks, dt, tickTime, basinY, basinZ, simWorkers);
+        });
+
+    // ID picking: the pixel the next ID pass draws (GL window coordinates)
+    bool pickPending = false;
+    int pickX = 0, pickY = 0;
 
     while (!glfwWindowShouldClose(window))
     {
@@ -1004,6 +1654,7 @@ int main()
 
 
         processInput(window);
+        hotReload.update();
 
         static bool key1Pressed = false;
         static bool key2Pressed = false;
@@ -1038,29 +1689,114 @@ int main()
             key2Pressed = false;
         }
 
+        static bool key3Pressed = false;
+        static bool key4Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS && !key3Pressed)
+        {
+            key3Pressed = true;
+            frustumCuller.enabled = !frustumCuller.enabled;
+
+            std::cout << "Frustum culling: " << (frustumCuller.enabled ? "ON" : "OFF") << std::endl;
+        }
+        if (glfwGetKey(window, GLFW_KEY_3) == GLFW_RELEASE)
+        {
+            key3Pressed = false;
+        }
+
+        if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS && !key4Pressed)
+        {
+            key4Pressed = true;
+            occlusionCuller.enabled = !occlusionCuller.enabled;
+
+            std::cout << "Occlusion culling: " << (occlusionCuller.enabled ? "ON" : "OFF") << std::endl;
+        }
+        if (glfwGetKey(window, GLFW_KEY_4) == GLFW_RELEASE)
+        {
+            key4Pressed = false;
+        }
+
+        static bool key5Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_5) == GLFW_PRESS && !key5Pressed)
+        {
+            key5Pressed = true;
+            gpuOcclusion.enabled = !gpuOcclusion.enabled;
+
+            std::cout << "GPU occlusion queries: " << (gpuOcclusion.enabled ? "ON" : "OFF") << std::endl;
+        }
+        if (glfwGetKey(window, GLFW_KEY_5) == GLFW_RELEASE)
+        {
+            key5Pressed = false;
+        }
+
+        static bool key6Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_6) == GLFW_PRESS && !key6Pressed)
+        {
+            key6Pressed = true;
+            gpuDroplets.enabled = !gpuDroplets.enabled;
+
+            SimCommand cmd;
+            cmd.type = SIM_GPU_DROPLETS;
+            cmd.count = gpuDroplets.enabled ? 1 : 0;
+            sendSim(cmd);
 
-        // temp drift towards target when on
-        if (klimaOn) {
-            float speed = 1.0f;
-            if (currentTemp < (float)targetTemp) currentTemp = std::min((float)targetTemp, currentTemp + speed * deltaTime);
-            if (currentTemp > (float)targetTemp) currentTemp = std::max((float)targetTemp, currentTemp - speed * deltaTime);
+            std::cout << "GPU droplets: " << (gpuDroplets.enabled ? "ON" : "OFF") << std::endl;
+        }
+        if (glfwGetKey(window, GLFW_KEY_6) == GLFW_RELEASE)
+        {
+            key6Pressed = false;
         }
 
-        // droplets fill
-        updateDroplets(deltaTime, basinY, basinZ);
+        static bool key7Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_7) == GLFW_PRESS && !key7Pressed)
+        {
+            key7Pressed = true;
+            probeAtCamera = !probeAtCamera;
+
+            std::cout << "Temperature probe: " << (probeAtCamera ? "CAMERA" : "AC SENSOR") << std::endl;
+        }
+        if (glfwGetKey(window, GLFW_KEY_7) == GLFW_RELEASE)
+        {
+            key7Pressed = false;
+        }
+
+        static bool key8Pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_8) == GLFW_PRESS && !key8Pressed)
+        {
+            key8Pressed = true;
+            idPicking = !idPicking;
+
+            std::cout << "Picking: " << (idPicking ? "ID BUFFER" : "RAY CAST") << std::endl;
+        }
+        if (glfwGetKey(window, GLFW_KEY_8) == GLFW_RELEASE)
+        {
+            key8Pressed = false;
+        }
 
-        // auto-off when full 
-        if (waterLevel >= 1.0f) {
-            waterLevel = 1.0f;
-            klimaOn = false;
-            basinFull = true;
+        // the readout follows the camera through the room, or shows what the AC measures
+        static glm::vec3 probeSent(-1.0e9f);
+        const glm::vec3 probeAt = probeAtCamera ? camera.Position : acSensorPos();
+        if (probeAt != probeSent)
+        {
+            SimCommand probe;
+            probe.type = SIM_PROBE;
+            probe.position = probeAt;
+            sendSim(probe);
+            probeSent = probeAt;
         }
 
-        // lid animation
-        float targetLid = klimaOn ? 1.0f : 0.0f;
-        float step = LID_SPEED * deltaTime;
-        if (lidT < targetLid) lidT = std::min(targetLid, lidT + step);
-        else                  lidT = std::max(targetLid, lidT - step);
+
+        // simulation: the newest snapshot, drawn between its last two ticks
+        simSnapshots.acquire();
+        frameSim = &simSnapshots.front();
+        shownAlpha = std::chrono::duration<float>(SimThread::Clock::now() - frameSim->tickTime).count() / frameSim->tickDt;
+        shownAlpha = clampf(shownAlpha, 0.0f, 1.0f);
+        shown = lerpSim(frameSim->previous, frameSim->current, shownAlpha);
+
+        if (frameSim->rippleVersion != uploadedRippleVersion && !frameSim->ripples.empty()) {
+            water.upload(frameSim->ripples.data());
+            uploadedRippleVersion = frameSim->rippleVersion;
+        }
+        stepGpuDroplets(deltaTime, basinY, basinZ);
 
         glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -1071,26 +1807,10 @@ int main()
         glm::mat4 P = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f);
         glm::mat4 V = camera.GetViewMatrix();
 
-        // click: pick basin only when full and not held
-        if (mouseClicked) {
-            mouseClicked = false;
-
-            if (basinFull && !basinHeld) {
-                glm::vec3 ro = camera.Position;
-                glm::vec3 rd = screenRayDir(clickX, clickY, width, height, P, V);
-
-                glm::vec3 basinCenter = glm::vec3(0.0f, basinY, basinZ);
-
-                float tHit = 0.0f;
-                if (raySphereHitDist(ro, rd, basinCenter, BASIN_PICK_RADIUS, tHit) && tHit < BASIN_PICK_DISTANCE)
-                {
-                    basinHeld = true;
-                }
-            }
-        }
+        frameUniforms.update(P, V, glm::vec3(2.0f, 4.0f, 2.0f), camera.Position, glm::vec3(1.0f, 1.0f, 1.0f));
 
         // if held -> place in front of camera
-        if (basinHeld) {
+        if (frameSim->basinHeld) {
             const float holdDist = 0.75f;
             const float holdDown = 0.35f;
             basinPos = camera.Position + camera.Front * holdDist - camera.Up * holdDown;
@@ -1099,142 +1819,169 @@ int main()
             basinPos = basinPosDefault;
         }
 
-        // SPACE logic
-        if (pendingSpace) {
-            pendingSpace = false;
+        // the tree follows what moved, then answers the frustum once for the whole frame
+        updateSceneObjects(shown.lidT, !frameSim->basinHeld, frameSim->klimaOn, shown.waterLevel, basinY, basinZ);
+        const Frustum frustum = camera.GetFrustum(P);
+        markVisible(frustum);
 
-            if (basinHeld) {
-                glm::vec3 camF = glm::normalize(glm::vec3(camera.Front.x, 0.0f, camera.Front.z));
-                glm::vec3 toAC = glm::normalize(glm::vec3(AC_POS.x - camera.Position.x, 0.0f, AC_POS.z - camera.Position.z));
-
-                float angToAC = angleDegXZ(camF, toAC);
-                float angAway = angleDegXZ(camF, -toAC);
-
-                const float TOL = 35.0f;
-
-                if (basinFull && angAway <= TOL) {
-                    waterLevel = 0.0f;
-                    basinFull = false;
-                }
-                else if (!basinFull && angToAC <= TOL) {
-                    basinHeld = false;
-                    basinPos = basinPosDefault;
+        // click: a ray cast into the scene right away, or the pixel under the cursor in this
+        // frame's ID pass (resolved below, a frame or two later)
+        if (mouseClicked) {
+            mouseClicked = false;
 
-                    klimaOn = false;
-                    targetTemp = 24;
-                    currentTemp = 31.0f;
-                    lidT = 0.0f;
+            // the cursor is captured for mouse look: clicks go through the middle of the screen
+            double mx = clickX, my = clickY;
+            if (glfwGetInputMode(window, GLFW_CURSOR) == GLFW_CURSOR_DISABLED) {
+                mx = width * 0.5;
+                my = height * 0.5;
+            }
 
-                    initDroplets();
+            if (idPicking) {
+                pickPending = true;
+                pickX = (int)mx;
+                pickY = height - 1 - (int)my;
+            }
+            else {
+                RayHit hit = sceneObjects.cast(camera.Position, screenRayDir(mx, my, width, height, P, V));
+                if (hit.hit()) {
+                    std::cout << "Picked: " << sceneObjects.name(hit.instance) << " (triangle " << hit.triangle
+                        << ", " << hit.t << " m)" << std::endl;
+                    clickedObject(hit.instance, hit.t);
                 }
             }
         }
 
-        // ===== Draw cubes scene =====
-        shader.use();
-        shader.setVec3("uLightPos", 2.0f, 4.0f, 2.0f);
-        shader.setVec3("uViewPos", camera.Position);
-        shader.setVec3("uLightColor", 1.0f, 1.0f, 1.0f);
-        shader.setMat4("uP", P);
-        shader.setMat4("uV", V);
-
-        glm::mat4 M;
-
-        // room
-        shader.setVec3("uObjectColor", 0.8f, 0.8f, 0.8f);
-
-        // floor
-        M = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, FLOOR_Y, 0.0f));
-        M = glm::scale(M, glm::vec3(6.0f, FLOOR_THICK, 6.0f));
-        shader.setMat4("uM", M); drawCube();
-
-        // ceiling
-        M = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 3.0f, 0.0f));
-        M = glm::scale(M, glm::vec3(6.0f, 0.1f, 6.0f));
-        shader.setMat4("uM", M); drawCube();
-
-        // walls
-        M = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f, 1.5f, 0.0f));
-        M = glm::scale(M, glm::vec3(0.1f, 3.0f, 6.0f));
-        shader.setMat4("uM", M); drawCube();
-
-        M = glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 1.5f, 0.0f));
-        M = glm::scale(M, glm::vec3(0.1f, 3.0f, 6.0f));
-        shader.setMat4("uM", M); drawCube();
-
-        M = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.5f, -3.0f));
-        M = glm::scale(M, glm::vec3(6.0f, 3.0f, 0.1f));
-        shader.setMat4("uM", M); drawCube();
-
-        M = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.5f, 3.0f));
-        M = glm::scale(M, glm::vec3(6.0f, 3.0f, 0.1f));
-        shader.setMat4("uM", M); drawCube();
-
-        // AC body
-        shader.setVec3("uObjectColor", 0.55f, 0.55f, 0.55f);
-        M = glm::translate(glm::mat4(1.0f), AC_POS);
-        M = glm::scale(M, AC_SCALE);
-        shader.setMat4("uM", M); drawCube();
-
-        // lid
-        drawKlimaLid(shader);
-
-        // lamp + screens
-        drawLampCircle(shader);
-        drawScreen3D(shader, SCREEN_X_LEFT);
-        drawScreen3D(shader, SCREEN_X_MID);
-        drawScreen3D(shader, SCREEN_X_RIGHT);
+        PickResult picked;
+        if (pickBuffer.poll(picked)) {
+            if (picked.id == 0 || picked.id > sceneObjects.size()) {
+                std::cout << "Picked: nothing (ID buffer, " << picked.frames << " frames later)" << std::endl;
+            }
+            else {
+                const int id = (int)picked.id - 1;
+                const float t = glm::distance(picked.point, camera.Position);
+                std::cout << "Picked: " << sceneObjects.name(id) << " (ID buffer, " << t << " m, "
+                    << picked.frames << " frames later)" << std::endl;
+                clickedObject(id, t);
+            }
+        }
 
-        // digits + icon only when klimaOn
-        if (klimaOn)
-        {
-            drawNumber2DLike3D(shader, targetTemp, glm::vec3(SCREEN_X_LEFT, screenY, screenZ));
-            drawNumber2DLike3D(shader, (int)std::round(currentTemp), glm::vec3(SCREEN_X_MID, screenY, screenZ));
-
-            drawStatusIcon(texShader, P, V);
-
-            // restore main shader after texShader.use()
-            shader.use();
-            shader.setMat4("uP", P);
-            shader.setMat4("uV", V);
-            shader.setVec3("uLightPos", 2.0f, 4.0f, 2.0f);
-            shader.setVec3("uViewPos", camera.Position);
-            shader.setVec3("uLightColor", 1.0f, 1.0f, 1.0f);
+        // ===== Record cubes scene =====
+        objectBuffer.clear();
+        basicPass.clear();
+        cubeBatch.clear();
+        frustumCuller.clear();
+        occlusionCuller.begin(P * V);
+
+        // room + AC body: nothing to rebuild, rebakes only if the static set changed
+        staticScene.bake();
+        staticScene.submit(objectBuffer, frustumCuller, occlusionCuller);
+
+        // lid (objects the tree found out of view aren't recorded at all; every record carries
+        // the pick id of its scene object for the ID pass)
+        objectBuffer.pickId = pickIdOf(objLid);
+        if (inView(objLid))
+            drawKlimaLid(shown.lidT);
+
+        // lamp (part of the AC) + screens
+        objectBuffer.pickId = pickIdOf(objAC);
+        drawLampCircle();
+        const float screenXs[3] = { SCREEN_X_LEFT, SCREEN_X_MID, SCREEN_X_RIGHT };
+        for (int k = 0; k < 3; k++) {
+            objectBuffer.pickId = pickIdOf(objScreens[k]);
+            if (inView(objScreens[k]))
+                drawScreen3D(screenXs[k]);
         }
 
-        // basin
-        shader.setVec3("uObjectColor", 0.25f, 0.55f, 0.95f);
-        M = glm::translate(glm::mat4(1.0f), basinPos);
-        M = glm::scale(M, glm::vec3(basinScale));
-        shader.setMat4("uM", M); drawBasin();
+        objectBuffer.pickId = pickIdOf(objBasin);
+        if (inView(objBasin)) {
+            // basin
+            submitBasin(basinMatrix(basinPos), glm::vec3(0.25f, 0.55f, 0.95f));
 
-        // water (follows basin)
-        updateWaterMesh(64, waterLevel, basinPos.x, basinPos.y, basinPos.z);
-        if (waterVertexCount > 0)
-        {
-            shader.setVec3("uObjectColor", 0.25f, 0.60f, 1.0f);
-            shader.setMat4("uM", glm::mat4(1.0f));
-            glBindVertexArray(waterVAO);
-            glDrawArrays(GL_TRIANGLES, 0, waterVertexCount);
-            glBindVertexArray(0);
+            // water (follows basin; the mesh is static, only its record + shape change)
+            glm::vec4 shape = waterShape(shown.waterLevel, basinPos.y);
+            water.submit(objectBuffer, frustumCuller, basinPos, shape.x, shape.y, shape.z, shape.w, glm::vec3(0.25f, 0.60f, 1.0f));
+        }
+        else {
+            water.hide();
         }
 
         // droplets
-        drawDroplets(shader);
+        objectBuffer.pickId = pickIdOf(objDroplets);
+        drawDroplets(basinY, basinZ);
+
+        // OBJ models (toilet + remote) share the same object buffer
+        ModelItem toiletItem, remoteItem;
+        objectBuffer.pickId = pickIdOf(objToilet);
+        if (inView(objToilet))
+            toiletItem = submitModel(toilet, toiletModelMatrix(), toiletQuery);
+        objectBuffer.pickId = pickIdOf(objRemote);
+        if (!frameSim->basinHeld && inView(objRemote))
+            remoteItem = submitModel(remoteM, remoteModelMatrix());
+        objectBuffer.pickId = 0;
+
+        // ===== Frustum culling: all recorded bounds in one SIMD pass =====
+        frustumCuller.run(frustum);
+
+        // ===== Occlusion culling: survivors hidden behind the room / AC body =====
+        // only valid while the depth test is on; without it hidden objects would still paint over
+        if (glIsEnabled(GL_DEPTH_TEST)) {
+            occlusionCuller.render(workers);
+            occlusionCuller.cull(frustumCuller, workers);
+        }
 
-        // ===== Draw OBJ models (toilet + remote) =====
-        applyModelCommonUniforms(modelShader, P, V);
+        // ===== Upload per-object data once, then draw =====
+        objectBuffer.upload();
+        objectBuffer.bind();
 
-        drawToiletModel(toilet, modelShader);
-        if (!basinHeld) {
-            drawRemoteModel(remoteM, modelShader);
+        flushBasicPass(basicShaders);
+
+        // digits + icon only when klimaOn
+        if (frameSim->klimaOn)
+        {
+            drawNumberDisplay(segmentShader, frameSim->targetTemp, glm::vec3(SCREEN_X_LEFT, screenY, screenZ));
+            drawNumberDisplay(segmentShader, (int)std::round(shown.currentTemp), glm::vec3(SCREEN_X_MID, screenY, screenZ));
+            drawStatusIcon(texShader);
         }
+
+        // ===== Draw OBJ models (toilet + remote) =====
+        gpuOcclusion.beginFrame();
+        drawModel(toilet, modelShaders, toiletItem);
+        drawModel(remoteM, modelShaders, remoteItem);
+
+        // ===== ID pass: the clicked pixel once more, pick ids instead of colors =====
+        // same records, same culling, every program swapped for its PICK variant
+        if (pickPending) {
+            pickPending = false;
+            const bool queued = pickBuffer.pick(width, height, pickX, pickY, P * V, [&] {
+                basicShaders.passFeatures = BASIC_PICK;
+                modelShaders.passFeatures = MESH_PICK;
+                flushBasicPass(basicShaders);
+
+                ModelItem toiletIds = toiletItem;
+                toiletIds.query = -1;   // the occlusion query of this frame is already issued
+                drawModel(toilet, modelShaders, toiletIds);
+                drawModel(remoteM, modelShaders, remoteItem);
+
+                if (inView(objIcon)) {
+                    texPickShader.use();
+                    texPickShader.setInt(U_PICK_ID, (int)pickIdOf(objIcon));
+                    drawStatusIcon(texPickShader);
+                }
+                basicShaders.passFeatures = 0;
+                modelShaders.passFeatures = 0;
+            });
+            if (!queued)
+                std::cout << "Pick dropped: " << PICK_READBACKS << " readbacks still in flight" << std::endl;
+        }
+
+        reportCullStats(t);
         drawNameUI(uiShader);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    simThread.stop();
     glfwTerminate();
     return 0;
 }
@@ -23,6 +23,13 @@ struct Vertex {
     glm::vec2 TexCoords;
 };
 
+// model.frag permutation bits, in the order of the ShaderVariants feature list
+enum MeshFeature : unsigned int {
+    MESH_DIFFUSE_MAP = 1u << 0,
+    MESH_SPEC_MAP = 1u << 1,
+    MESH_PICK = 1u << 2         // pick id instead of color (ID pass, see pick_buffer.hpp)
+};
+
 struct Texture {
     unsigned int id;
     string type;
@@ -36,6 +43,8 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    // MeshFeature bits: which model.frag variant this mesh needs
+    unsigned int features = 0;
 
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
@@ -46,28 +55,18 @@ public:
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
+        setupSamplerNames();
     }
 
     // render the mesh
     void Draw(Shader& shader)
     {
         // bind appropriate textures
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr = 1;
         for (unsigned int i = 0; i < textures.size(); i++)
         {
             glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if (name == "uDiffMap")
-                number = std::to_string(diffuseNr++);
-            else
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-
             // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+            shader.setInt(samplerNames[i], i);
             // and finally bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
@@ -84,6 +83,26 @@ public:
 private:
     // render data 
     unsigned int VBO, EBO;
+    // sampler uniform of every texture ("uDiffMap1", "uSpecMap1", ...), built once
+    vector<string> samplerNames;
+
+    void setupSamplerNames()
+    {
+        unsigned int diffuseNr = 1;
+        unsigned int specularNr = 1;
+        for (unsigned int i = 0; i < textures.size(); i++)
+        {
+            // retrieve texture number (the N in diffuse_textureN)
+            string number;
+            string name = textures[i].type;
+            if (name == "uDiffMap")
+                number = std::to_string(diffuseNr++);
+            else
+                number = std::to_string(specularNr++); // transfer unsigned int to string
+            samplerNames.push_back(name + number);
+            features |= (name == "uDiffMap") ? MESH_DIFFUSE_MAP : MESH_SPEC_MAP;
+        }
+    }
 
     // initializes all the buffer objects/arrays
     void setupMesh()
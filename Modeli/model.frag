@@ -1,20 +1,43 @@
 #version 330 core
+// features (see ShaderVariants): DIFFUSE_MAP, SPEC_MAP, PICK
+#ifdef PICK
+out uint FragId;   // R32UI target of the ID pass (see pick_buffer.hpp)
+flat in uint vPickId;
+#else
 out vec4 FragColor;
+#endif
 
 in vec3 vNormal;
 in vec3 vFragPos;
 in vec2 vTex;
 
-uniform vec3 uLightPos;
-uniform vec3 uViewPos;
-uniform vec3 uLightColor;
+layout (std140) uniform FrameData
+{
+    mat4 uP;
+    mat4 uV;
+    mat4 uVP;
+    vec3 uLightPos;
+    vec3 uViewPos;
+    vec3 uLightColor;
+};
 
+#ifdef DIFFUSE_MAP
 uniform sampler2D uDiffMap1;
+#endif
+#ifdef SPEC_MAP
 uniform sampler2D uSpecMap1;
+#endif
 
 void main()
 {
+#ifdef PICK
+    FragId = vPickId;
+#else
+#ifdef DIFFUSE_MAP
     vec3 base = texture(uDiffMap1, vTex).rgb;
+#else
+    vec3 base = vec3(1.0);
+#endif
 
     // ambient
     float ambientStrength = 0.2;
@@ -26,14 +49,18 @@ void main()
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * uLightColor;
 
-    // specular 
+    vec3 result = (ambient + diffuse) * base;
+
+#ifdef SPEC_MAP
+    // specular (only meshes that have a specular map pay for it)
     float specularStrength = 0.5;
     vec3 viewDir = normalize(uViewPos - vFragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
     vec3 specMap = texture(uSpecMap1, vTex).rgb;
-    vec3 specular = specularStrength * spec * uLightColor * specMap;
+    result += specularStrength * spec * uLightColor * specMap;
+#endif
 
-    vec3 result = (ambient + diffuse) * base + specular;
     FragColor = vec4(result, 1.0);
+#endif
 }
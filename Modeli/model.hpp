@@ -20,6 +20,7 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <cfloat>
 
 using namespace std;
 
@@ -33,6 +34,9 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // model-space box around every vertex of every mesh (culling)
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
 
     // constructor, expects a filepath to a 3D model.
     Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
@@ -79,7 +83,11 @@ private:
 
         std::cout << "ASSIMP OK: meshes = " << scene->mNumMeshes << "\n";
 
+        boundsMin = glm::vec3(FLT_MAX);
+        boundsMax = glm::vec3(-FLT_MAX);
         processNode(scene->mRootNode, scene);
+        if (boundsMin.x > boundsMax.x)
+            boundsMin = boundsMax = glm::vec3(0.0f);
     }
 
 
@@ -119,6 +127,8 @@ private:
             vector.y = mesh->mVertices[i].y;
             vector.z = mesh->mVertices[i].z;
             vertex.Position = vector;
+            boundsMin = glm::min(boundsMin, vector);
+            boundsMax = glm::max(boundsMax, vector);
             // normals
             if (mesh->HasNormals())
             {
@@ -6,15 +6,48 @@ layout (location = 2) in vec2 inTex;
 out vec3 vFragPos;
 out vec3 vNormal;
 out vec2 vTex;
+#ifdef PICK
+flat out uint vPickId;   // ID pass (see pick_buffer.hpp)
+#endif
 
-uniform mat4 uM;
-uniform mat4 uV;
-uniform mat4 uP;
+layout (std140) uniform FrameData
+{
+    mat4 uP;
+    mat4 uV;
+    mat4 uVP;
+    vec3 uLightPos;
+    vec3 uViewPos;
+    vec3 uLightColor;
+};
+
+// per-object records, OBJECT_TEXELS texels each (see object_buffer.hpp)
+uniform samplerBuffer uObjects;
+uniform int uObjectIndex;
+
+mat4 objectModel(int i)
+{
+    int b = i * 8;
+    return mat4(texelFetch(uObjects, b), texelFetch(uObjects, b + 1),
+                texelFetch(uObjects, b + 2), texelFetch(uObjects, b + 3));
+}
+
+// inverse-transpose of the model matrix, precomputed on the CPU
+mat3 objectNormal(int i)
+{
+    int b = i * 8 + 4;
+    return mat3(texelFetch(uObjects, b).xyz, texelFetch(uObjects, b + 1).xyz,
+                texelFetch(uObjects, b + 2).xyz);
+}
 
 void main()
 {
-    vFragPos = vec3(uM * vec4(inPos, 1.0));
-    vNormal  = mat3(transpose(inverse(uM))) * inNormal;
+    mat4 M = objectModel(uObjectIndex);
+
+    vFragPos = vec3(M * vec4(inPos, 1.0));
+    vNormal  = objectNormal(uObjectIndex) * inNormal;
     vTex     = inTex;
-    gl_Position = uP * uV * vec4(vFragPos, 1.0);
+#ifdef PICK
+    vPickId  = uint(texelFetch(uObjects, uObjectIndex * 8 + 4).w);
+#endif
+    gl_Position = uVP * vec4(vFragPos, 1.0);
 }
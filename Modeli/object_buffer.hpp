@@ -0,0 +1,140 @@
+#ifndef OBJECT_BUFFER_H
+#define OBJECT_BUFFER_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "shader.hpp"
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+// texture unit reserved for the object buffer (mesh textures use the low units)
+const unsigned int OBJECT_BUFFER_UNIT = 8;
+
+// one record per drawn object, read in the vertex shader with texelFetch (RGBA32F texels)
+struct ObjectData {
+    glm::mat4 M;
+    glm::vec4 N[3];     // normal matrix columns (xyz), padded to a texel each; N[0].w = pick id
+    glm::vec4 color;
+};
+const int OBJECT_TEXELS = sizeof(ObjectData) / sizeof(glm::vec4);
+
+// inverse-transpose of the upper 3x3 of M, computed once per object instead of per vertex.
+// almost everything in the scene is rotate/translate/scale, whose columns stay orthogonal:
+// then A = R * S and inverse(A)^T = R * S^-1, i.e. every column divided by its squared length.
+// with a uniform scale even that is unnecessary because the shader normalizes the normal.
+static inline glm::mat3 normalMatrix(const glm::mat4& M)
+{
+    glm::mat3 A(M);
+    const glm::vec3 c0 = A[0], c1 = A[1], c2 = A[2];
+
+    const float l0 = glm::dot(c0, c0);
+    const float l1 = glm::dot(c1, c1);
+    const float l2 = glm::dot(c2, c2);
+    if (l0 < 1e-12f || l1 < 1e-12f || l2 < 1e-12f) return A; // degenerate, nothing sensible to invert
+
+    const float eps = 1e-4f;
+    const float d01 = glm::dot(c0, c1);
+    const float d02 = glm::dot(c0, c2);
+    const float d12 = glm::dot(c1, c2);
+    const bool orthogonal =
+        d01 * d01 <= eps * eps * l0 * l1 &&
+        d02 * d02 <= eps * eps * l0 * l2 &&
+        d12 * d12 <= eps * eps * l1 * l2;
+
+    if (orthogonal)
+    {
+        if (std::fabs(l0 - l1) <= eps * l0 && std::fabs(l0 - l2) <= eps * l0)
+            return A; // rotation * uniform scale
+
+        return glm::mat3(c0 / l0, c1 / l1, c2 / l2);
+    }
+
+    // shear / skew: full inverse
+    return glm::transpose(glm::inverse(A));
+}
+
+// per-object constants of a frame, filled on the CPU and uploaded once as a texture buffer.
+// shaders fetch their record with "uObjects" + "uObjectIndex".
+class ObjectBuffer {
+public:
+    std::vector<ObjectData> objects;
+    unsigned int TBO = 0;
+    unsigned int tex = 0;
+
+    // stamped into every record pushed from now on, what the ID pass writes (pick_buffer.hpp);
+    // 0 = nothing. exact as a float up to 2^24
+    uint32_t pickId = 0;
+
+    void init(size_t initialCapacity = 256)
+    {
+        capacity = initialCapacity;
+
+        glGenBuffers(1, &TBO);
+        glBindBuffer(GL_TEXTURE_BUFFER, TBO);
+        glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(ObjectData), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_BUFFER, tex);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, TBO);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        objects.reserve(capacity);
+    }
+
+    // point a program's "uObjects" sampler at the reserved unit (once, after linking)
+    void attach(Shader& shader) const
+    {
+        shader.bindSampler("uObjects", OBJECT_BUFFER_UNIT);
+    }
+
+    void clear()
+    {
+        objects.clear();
+        pickId = 0;
+    }
+
+    // returns the index the shader uses to find this record
+    int push(const glm::mat4& M, const glm::vec3& color)
+    {
+        glm::mat3 N = normalMatrix(M);
+
+        ObjectData d;
+        d.M = M;
+        d.N[0] = glm::vec4(N[0], (float)pickId);
+        d.N[1] = glm::vec4(N[1], 0.0f);
+        d.N[2] = glm::vec4(N[2], 0.0f);
+        d.color = glm::vec4(color, 1.0f);
+        objects.push_back(d);
+        return (int)objects.size() - 1;
+    }
+
+    // one buffer update per frame; orphans the old storage so the driver never waits on it
+    void upload()
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, TBO);
+        if (objects.size() > capacity) {
+            while (capacity < objects.size()) capacity *= 2;
+        }
+        glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(ObjectData), nullptr, GL_STREAM_DRAW);
+        if (!objects.empty())
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, objects.size() * sizeof(ObjectData), objects.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void bind() const
+    {
+        glActiveTexture(GL_TEXTURE0 + OBJECT_BUFFER_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, tex);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    size_t capacity = 0;
+};
+
+#endif
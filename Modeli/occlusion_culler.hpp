@@ -0,0 +1,342 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/glm.hpp>
+
+#include "culling.hpp"
+#include "parallel.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+// software depth buffer used for occlusion culling (no GPU involved)
+const int OCCLUSION_W = 256;
+const int OCCLUSION_H = 128;
+const int OCCLUSION_TILE_W = 64;     // raster work is split into tiles, one task each
+const int OCCLUSION_TILE_H = 32;
+const int OCCLUSION_BLOCK = 8;       // hierarchical level: max depth of 8x8 pixels
+
+const int OCCLUSION_TILES_X = OCCLUSION_W / OCCLUSION_TILE_W;
+const int OCCLUSION_TILES_Y = OCCLUSION_H / OCCLUSION_TILE_H;
+const int OCCLUSION_BLOCKS_X = OCCLUSION_W / OCCLUSION_BLOCK;
+const int OCCLUSION_BLOCKS_Y = OCCLUSION_H / OCCLUSION_BLOCK;
+
+// CPU occlusion culling.
+// designated occluders (big closed boxes: walls, floor, AC body, model proxies) are rasterized
+// into a small depth buffer every frame:
+//  1. occluder triangles are transformed and clipped against the near plane (parallel per occluder)
+//  2. binned into screen tiles
+//  3. every tile is rasterized by its own task (4 pixels per step with SSE), so no locking
+//  4. the max depth of each 8x8 block is stored next to the pixels
+// an object is occluded when the nearest point of its bounds lies behind every pixel it covers;
+// the block level answers most of that without touching the pixels.
+class OcclusionCuller {
+public:
+    bool enabled = true;
+
+    OcclusionCuller()
+    {
+        depth.assign(OCCLUSION_W * OCCLUSION_H, 1.0f);
+        blockMax.assign(OCCLUSION_BLOCKS_X * OCCLUSION_BLOCKS_Y, 1.0f);
+    }
+
+    // starts a frame seen through VP; forgets the previous occluders
+    void begin(const glm::mat4& VP)
+    {
+        viewProj = VP;
+        occluders.clear();
+        rendered = false;
+    }
+
+    // closed box [lo, hi] in model space, placed by M
+    void addOccluder(const glm::mat4& M, const glm::vec3& lo, const glm::vec3& hi)
+    {
+        occluders.push_back({ M, lo, hi });
+    }
+
+    void render(ThreadPool& pool)
+    {
+        rendered = false;
+        if (!enabled) return;
+
+        // 1. transform + clip, every occluder writes only its own slots
+        triangles.resize(occluders.size() * MAX_TRIS_PER_BOX);
+        triangleCounts.assign(occluders.size(), 0);
+        pool.parallelFor(occluders.size(), 4, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                triangleCounts[i] = setupBox(occluders[i], &triangles[i * MAX_TRIS_PER_BOX]);
+        });
+
+        // 2. bin by screen bounds
+        for (std::vector<uint32_t>& bin : bins) bin.clear();
+        for (size_t i = 0; i < occluders.size(); i++)
+        {
+            for (int k = 0; k < triangleCounts[i]; k++)
+            {
+                uint32_t index = (uint32_t)(i * MAX_TRIS_PER_BOX + k);
+                const ScreenTri& t = triangles[index];
+                int tx0 = t.minX / OCCLUSION_TILE_W, tx1 = t.maxX / OCCLUSION_TILE_W;
+                int ty0 = t.minY / OCCLUSION_TILE_H, ty1 = t.maxY / OCCLUSION_TILE_H;
+                for (int ty = ty0; ty <= ty1; ty++)
+                    for (int tx = tx0; tx <= tx1; tx++)
+                        bins[ty * OCCLUSION_TILES_X + tx].push_back(index);
+            }
+        }
+
+        // 3 + 4. clear, rasterize and reduce every tile independently
+        pool.parallelFor(OCCLUSION_TILES_X * OCCLUSION_TILES_Y, 1, [&](size_t begin, size_t end) {
+            for (size_t tile = begin; tile < end; tile++)
+                rasterTile((int)tile);
+        });
+        rendered = true;
+    }
+
+    // conservative: true unless the sphere is certainly hidden behind the occluders
+    bool visible(const glm::vec4& sphere) const
+    {
+        if (!rendered) return true;
+
+        // the cube around the sphere; depth is monotonic in view z, so its corners bound it
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, minZ = 1e30f;
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec3 p(
+                sphere.x + ((c & 1) ? sphere.w : -sphere.w),
+                sphere.y + ((c & 2) ? sphere.w : -sphere.w),
+                sphere.z + ((c & 4) ? sphere.w : -sphere.w));
+            glm::vec4 clip = viewProj * glm::vec4(p, 1.0f);
+            if (clip.w <= NEAR_W || clip.z < -clip.w) return true; // reaches the camera
+            float iw = 1.0f / clip.w;
+            minX = std::min(minX, clip.x * iw); maxX = std::max(maxX, clip.x * iw);
+            minY = std::min(minY, clip.y * iw); maxY = std::max(maxY, clip.y * iw);
+            minZ = std::min(minZ, clip.z * iw);
+        }
+        const float nearest = minZ * 0.5f + 0.5f;
+
+        // covered pixels, grown by one because occluders are sampled at pixel centers
+        int x0 = (int)std::floor((minX * 0.5f + 0.5f) * OCCLUSION_W) - 1;
+        int x1 = (int)std::floor((maxX * 0.5f + 0.5f) * OCCLUSION_W) + 1;
+        int y0 = (int)std::floor((minY * 0.5f + 0.5f) * OCCLUSION_H) - 1;
+        int y1 = (int)std::floor((maxY * 0.5f + 0.5f) * OCCLUSION_H) + 1;
+        if (x1 < 0 || y1 < 0 || x0 >= OCCLUSION_W || y0 >= OCCLUSION_H) return true; // frustum's job
+        x0 = std::max(x0, 0); y0 = std::max(y0, 0);
+        x1 = std::min(x1, OCCLUSION_W - 1); y1 = std::min(y1, OCCLUSION_H - 1);
+
+        for (int by = y0 / OCCLUSION_BLOCK; by <= y1 / OCCLUSION_BLOCK; by++)
+        {
+            for (int bx = x0 / OCCLUSION_BLOCK; bx <= x1 / OCCLUSION_BLOCK; bx++)
+            {
+                if (blockMax[by * OCCLUSION_BLOCKS_X + bx] < nearest) continue; // whole block in front
+
+                // only part of the block may be in front: look at the pixels under the rect
+                int px0 = std::max(x0, bx * OCCLUSION_BLOCK), px1 = std::min(x1, bx * OCCLUSION_BLOCK + OCCLUSION_BLOCK - 1);
+                int py0 = std::max(y0, by * OCCLUSION_BLOCK), py1 = std::min(y1, by * OCCLUSION_BLOCK + OCCLUSION_BLOCK - 1);
+                for (int y = py0; y <= py1; y++)
+                    for (int x = px0; x <= px1; x++)
+                        if (depth[y * OCCLUSION_W + x] >= nearest) return true;
+            }
+        }
+        return false;
+    }
+
+    // rejects every object the frustum kept but the occluders hide
+    void cull(FrustumCuller& culler, ThreadPool& pool)
+    {
+        if (!rendered) return;
+
+        const size_t n = (size_t)culler.count();
+        hidden.assign(n, 0);
+        pool.parallelFor(n, 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                if (culler.visible((int)i) && !visible(culler.sphere((int)i)))
+                    hidden[i] = 1;
+        });
+        for (size_t i = 0; i < n; i++)
+            if (hidden[i]) culler.reject((int)i);
+    }
+
+    int occluderCount() const
+    {
+        return (int)occluders.size();
+    }
+
+private:
+    static constexpr float NEAR_W = 1e-5f;
+    static const int MAX_TRIS_PER_BOX = 24;   // 12 faces, each may split in two at the near plane
+
+    struct Box {
+        glm::mat4 M;
+        glm::vec3 lo, hi;
+    };
+    // screen-space triangle: pixel coordinates + depth in [0, 1]
+    struct ScreenTri {
+        float x[3], y[3], z[3];
+        int minX, maxX, minY, maxY;
+    };
+
+    glm::mat4 viewProj = glm::mat4(1.0f);
+    std::vector<Box> occluders;
+    std::vector<ScreenTri> triangles;
+    std::vector<int> triangleCounts;
+    std::vector<uint32_t> bins[OCCLUSION_TILES_X * OCCLUSION_TILES_Y];
+    std::vector<float> depth;
+    std::vector<float> blockMax;
+    std::vector<uint8_t> hidden;
+    bool rendered = false;
+
+    int setupBox(const Box& box, ScreenTri* out) const
+    {
+        static const int FACES[12][3] = {
+            { 0, 1, 3 }, { 0, 3, 2 },   // -x
+            { 4, 6, 7 }, { 4, 7, 5 },   // +x
+            { 0, 4, 5 }, { 0, 5, 1 },   // -y
+            { 2, 3, 7 }, { 2, 7, 6 },   // +y
+            { 0, 2, 6 }, { 0, 6, 4 },   // -z
+            { 1, 5, 7 }, { 1, 7, 3 }    // +z
+        };
+
+        const glm::mat4 MVP = viewProj * box.M;
+        glm::vec4 clip[8];
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec3 p((c & 4) ? box.hi.x : box.lo.x, (c & 2) ? box.hi.y : box.lo.y, (c & 1) ? box.hi.z : box.lo.z);
+            clip[c] = MVP * glm::vec4(p, 1.0f);
+        }
+
+        int count = 0;
+        for (const int* f : FACES)
+        {
+            // Sutherland-Hodgman against the near plane (z + w >= 0): 3 in, at most 4 out
+            glm::vec4 poly[4];
+            int n = 0;
+            for (int e = 0; e < 3; e++)
+            {
+                const glm::vec4& a = clip[f[e]];
+                const glm::vec4& b = clip[f[(e + 1) % 3]];
+                float da = a.z + a.w, db = b.z + b.w;
+                if (da >= 0.0f) poly[n++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f))
+                    poly[n++] = a + (b - a) * (da / (da - db));
+            }
+            for (int k = 1; k + 1 < n; k++)
+                count += setupTriangle(poly[0], poly[k], poly[k + 1], out + count);
+        }
+        return count;
+    }
+
+    static int setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, ScreenTri* out)
+    {
+        const glm::vec4* v[3] = { &a, &b, &c };
+        ScreenTri t;
+        float fx0 = 1e30f, fx1 = -1e30f, fy0 = 1e30f, fy1 = -1e30f;
+        for (int i = 0; i < 3; i++)
+        {
+            float w = std::max(v[i]->w, NEAR_W);
+            t.x[i] = (v[i]->x / w * 0.5f + 0.5f) * OCCLUSION_W;
+            t.y[i] = (v[i]->y / w * 0.5f + 0.5f) * OCCLUSION_H;
+            t.z[i] = std::min(std::max(v[i]->z / w * 0.5f + 0.5f, 0.0f), 1.0f);
+            fx0 = std::min(fx0, t.x[i]); fx1 = std::max(fx1, t.x[i]);
+            fy0 = std::min(fy0, t.y[i]); fy1 = std::max(fy1, t.y[i]);
+        }
+        if (fx1 < 0.0f || fy1 < 0.0f || fx0 >= OCCLUSION_W || fy0 >= OCCLUSION_H) return 0;
+        t.minX = std::max(0, (int)std::floor(fx0));
+        t.maxX = std::min(OCCLUSION_W - 1, (int)std::floor(fx1));
+        t.minY = std::max(0, (int)std::floor(fy0));
+        t.maxY = std::min(OCCLUSION_H - 1, (int)std::floor(fy1));
+        *out = t;
+        return 1;
+    }
+
+    void rasterTile(int tile)
+    {
+        const int tx = tile % OCCLUSION_TILES_X, ty = tile / OCCLUSION_TILES_X;
+        const int tileX0 = tx * OCCLUSION_TILE_W, tileY0 = ty * OCCLUSION_TILE_H;
+        const int tileX1 = tileX0 + OCCLUSION_TILE_W - 1, tileY1 = tileY0 + OCCLUSION_TILE_H - 1;
+
+        for (int y = tileY0; y <= tileY1; y++)
+            std::fill(&depth[y * OCCLUSION_W + tileX0], &depth[y * OCCLUSION_W + tileX0] + OCCLUSION_TILE_W, 1.0f);
+
+        for (uint32_t index : bins[tile])
+            rasterTriangle(triangles[index], std::max(tileX0, triangles[index].minX), std::min(tileX1, triangles[index].maxX),
+                std::max(tileY0, triangles[index].minY), std::min(tileY1, triangles[index].maxY));
+
+        // hierarchical level for the blocks of this tile
+        for (int by = tileY0 / OCCLUSION_BLOCK; by <= tileY1 / OCCLUSION_BLOCK; by++)
+        {
+            for (int bx = tileX0 / OCCLUSION_BLOCK; bx <= tileX1 / OCCLUSION_BLOCK; bx++)
+            {
+                float m = 0.0f;
+                for (int y = by * OCCLUSION_BLOCK; y < (by + 1) * OCCLUSION_BLOCK; y++)
+                    for (int x = bx * OCCLUSION_BLOCK; x < (bx + 1) * OCCLUSION_BLOCK; x++)
+                        m = std::max(m, depth[y * OCCLUSION_W + x]);
+                blockMax[by * OCCLUSION_BLOCKS_X + bx] = m;
+            }
+        }
+    }
+
+    // half-space rasterizer over [x0, x1] x [y0, y1], sampling pixel centers, depth test = min
+    void rasterTriangle(const ScreenTri& t, int x0, int x1, int y0, int y1)
+    {
+        float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+        if (std::fabs(area) < 1e-8f) return;
+        const float sign = area > 0.0f ? 1.0f : -1.0f;   // both windings are filled
+
+        // edge i is opposite vertex i: E(x, y) = A x + B y + C, >= 0 inside
+        float A[3], B[3], C[3];
+        for (int i = 0; i < 3; i++)
+        {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            A[i] = (t.y[j] - t.y[k]) * sign;
+            B[i] = (t.x[k] - t.x[j]) * sign;
+            C[i] = (t.x[j] * t.y[k] - t.x[k] * t.y[j]) * sign;
+        }
+        // depth is affine in screen space: z = zA x + zB y + zC
+        const float inv = 1.0f / (area * sign);
+        const float zA = (A[0] * t.z[0] + A[1] * t.z[1] + A[2] * t.z[2]) * inv;
+        const float zB = (B[0] * t.z[0] + B[1] * t.z[1] + B[2] * t.z[2]) * inv;
+        const float zC = (C[0] * t.z[0] + C[1] * t.z[1] + C[2] * t.z[2]) * inv;
+
+#if defined(CULLING_AVX) || defined(CULLING_SSE)
+        const int xs = x0 & ~3;   // tiles are 4-aligned, so whole steps never leave the tile
+        const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 zero = _mm_setzero_ps();
+        for (int y = y0; y <= y1; y++)
+        {
+            const float py = (float)y + 0.5f;
+            float* row = &depth[y * OCCLUSION_W];
+            for (int x = xs; x <= x1; x += 4)
+            {
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x + 0.5f), lane);
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[0]), px), _mm_set1_ps(B[0] * py + C[0]));
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[1]), px), _mm_set1_ps(B[1] * py + C[1]));
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[2]), px), _mm_set1_ps(B[2] * py + C[2]));
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), _mm_set1_ps(zB * py + zC));
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+        }
+#else
+        for (int y = y0; y <= y1; y++)
+        {
+            const float py = (float)y + 0.5f;
+            float* row = &depth[y * OCCLUSION_W];
+            for (int x = x0; x <= x1; x++)
+            {
+                const float px = (float)x + 0.5f;
+                if (A[0] * px + B[0] * py + C[0] < 0.0f) continue;
+                if (A[1] * px + B[1] * py + C[1] < 0.0f) continue;
+                if (A[2] * px + B[2] * py + C[2] < 0.0f) continue;
+                row[x] = std::min(row[x], zA * px + zB * py + zC);
+            }
+        }
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+
+// Fixed set of worker threads for data-parallel loops.
+// parallelFor() cuts [0, count) into chunks and deals them round-robin into one queue per
+// thread; everybody pops from the back of its own queue and, when that runs dry, steals from
+// the front of the others, so uneven chunks (e.g. busy raster tiles) balance out.
+// the calling thread works too and returns once every chunk is done.
+// one loop at a time: a parallelFor() issued from inside a chunk simply runs serially.
+class ThreadPool {
+public:
+    // 0 = one thread per hardware thread (counting the caller)
+    explicit ThreadPool(unsigned int threads = 0)
+    {
+        if (threads == 0)
+        {
+            unsigned int hw = std::thread::hardware_concurrency();
+            threads = hw > 1 ? hw - 1 : 0;
+        }
+        queues.reserve(threads + 1);
+        for (unsigned int i = 0; i <= threads; i++)
+            queues.push_back(std::make_unique<Queue>());
+        for (unsigned int i = 0; i < threads; i++)
+            workers.emplace_back([this, i] { workerLoop(i + 1); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // threads taking part in a loop, caller included
+    size_t size() const
+    {
+        return queues.size();
+    }
+
+    // fn(begin, end) is called for disjoint sub-ranges covering [0, count), 'grain' items at most each
+    template <class F>
+    void parallelFor(size_t count, size_t grain, F&& fn)
+    {
+        if (count == 0) return;
+        if (grain == 0) grain = 1;
+        if (insideChunk() || workers.empty() || count <= grain)
+        {
+            fn((size_t)0, count);
+            return;
+        }
+
+        std::function<void(size_t, size_t)> body(std::forward<F>(fn));
+        size_t chunks = (count + grain - 1) / grain;
+        pending.store(chunks, std::memory_order_relaxed);
+        job = &body;
+
+        for (size_t c = 0; c < chunks; c++)
+        {
+            Queue& q = *queues[c % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.items.push_back({ c * grain, std::min(count, (c + 1) * grain) });
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            generation++;
+        }
+        wake.notify_all();
+
+        // help until everything is finished (chunks in flight on other threads included)
+        while (pending.load(std::memory_order_acquire) > 0)
+        {
+            if (!runOne(0)) std::this_thread::yield();
+        }
+        job = nullptr;
+    }
+
+private:
+    struct Range {
+        size_t begin, end;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> items;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;   // [0] belongs to the caller
+    std::vector<std::thread> workers;
+    std::function<void(size_t, size_t)>* job = nullptr;
+    std::atomic<size_t> pending{ 0 };
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    static bool& insideChunk()
+    {
+        thread_local bool inside = false;
+        return inside;
+    }
+
+    bool pop(size_t self, Range& r)
+    {
+        {
+            Queue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.items.empty())
+            {
+                r = own.items.back();
+                own.items.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); k++)
+        {
+            Queue& victim = *queues[(self + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.items.empty())
+            {
+                r = victim.items.front();
+                victim.items.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool runOne(size_t self)
+    {
+        Range r;
+        if (!pop(self, r)) return false;
+        insideChunk() = true;
+        (*job)(r.begin, r.end);
+        insideChunk() = false;
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void workerLoop(size_t self)
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            while (runOne(self)) {}
+        }
+    }
+};
+
+// ----- thread-count sweeps of the --bench runs -----
+
+inline unsigned int hardwareThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// calls fn(threads, pool) for 1, 2, 4, ... threads and once more for every hardware thread,
+// with a fresh pool of that many threads (caller included). pool is null for one thread:
+// ThreadPool(0) would mean "all cores"
+template <class F>
+void forEachThreadCount(F&& fn)
+{
+    std::vector<unsigned int> counts = { 1 };
+    const unsigned int hw = hardwareThreads();
+    for (unsigned int t = 2; t < hw; t *= 2) counts.push_back(t);
+    if (hw > 1) counts.push_back(hw);
+
+    for (unsigned int threads : counts)
+    {
+        std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+        fn(threads, pool.get());
+    }
+}
+
+#endif
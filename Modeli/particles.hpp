@@ -0,0 +1,452 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "parallel.hpp"
+#include "object_buffer.hpp"
+#include "culling.hpp"
+#include "shader_variants.hpp"
+#include "random.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#define PARTICLES_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_SSE 1
+#include <emmintrin.h>
+#endif
+
+// particles per parallel chunk (a multiple of every SIMD width)
+const size_t PARTICLE_GRAIN = 16384;
+// impact positions kept per chunk and frame, for the water ripples
+const int PARTICLE_IMPACT_SAMPLES = 4;
+
+// attribute locations of the per-instance position streams (basic.vert, PARTICLE)
+const unsigned int PARTICLE_ATTRIB_X = 3;
+const unsigned int PARTICLE_ATTRIB_Y = 4;
+const unsigned int PARTICLE_ATTRIB_Z = 5;
+// vertical velocity, to draw droplets between two simulation ticks
+const unsigned int PARTICLE_ATTRIB_VY = 6;
+
+// emitter + collision setup of one update
+struct DropletParams {
+    glm::vec3 origin = glm::vec3(0.0f);   // outlet
+    float jitter = 0.0f;                  // spawn offset in x/z: origin +- jitter
+    float gravity = 0.0f;
+    float captureY = 0.0f;                // water surface
+    glm::vec2 captureCenter = glm::vec2(0.0f);  // basin axis (x, z)
+    float captureRadius = 0.0f;
+    float killY = -1.0f;                  // missed the basin: respawn below this
+};
+
+struct DropletImpacts {
+    int count = 0;                        // captured this update
+    std::vector<glm::vec2> samples;       // some of their (x, z) positions
+};
+
+// Droplets falling from the AC outlet, as a data-oriented particle system.
+// the state is SoA (x, y, z, vertical speed, RNG state); droplets only ever move straight down,
+// so there is no horizontal velocity to store. update() runs the whole step per chunk on the
+// thread pool: integrate, capture test against the basin, kill test and respawn, 8 lanes at a
+// time with AVX2 (respawn values are blended in), 4 with SSE2 (respawned lanes go scalar),
+// scalar otherwise. a droplet that lands respawns from its own randomNext01() stream (random.hpp),
+// the same one droplets_update.vert uses, so no RNG is shared. respawnAll() refills whole chunks
+// with Random::fill01 instead, one generator per chunk: the same numbers on any thread count.
+// the count is a quality knob: memory is 20 bytes per droplet and the work is linear in it.
+class DropletSystem {
+public:
+    void init(size_t count, uint32_t seed)
+    {
+        n = count;
+        const size_t padded = (count + 7) & ~(size_t)7;
+        px.assign(padded, 0.0f); py.assign(padded, 0.0f); pz.assign(padded, 0.0f); vy.assign(padded, 0.0f);
+        rng.resize(padded);
+        for (size_t i = 0; i < padded; i++)
+            rng[i] = randomSeed(seed, i);
+        spawnSeed = seed;
+        spawns = 0;
+        needsSpawn = true;
+    }
+
+    // puts every droplet back at the outlet
+    void respawnAll()
+    {
+        needsSpawn = true;
+    }
+
+    size_t size() const
+    {
+        return n;
+    }
+
+    // chunks spread over the pool
+    DropletImpacts update(float dt, const DropletParams& params, ThreadPool& pool)
+    {
+        return run(dt, params, [&](size_t count, auto&& body) { pool.parallelFor(count, PARTICLE_GRAIN, body); });
+    }
+
+    // everything on the calling thread
+    DropletImpacts update(float dt, const DropletParams& params)
+    {
+        return run(dt, params, [](size_t count, auto&& body) { body((size_t)0, count); });
+    }
+
+    // position + velocity streams for rendering, size() entries each
+    const float* x() const { return px.data(); }
+    const float* y() const { return py.data(); }
+    const float* z() const { return pz.data(); }
+    const float* velocityY() const { return vy.data(); }
+
+private:
+    size_t n = 0;
+    std::vector<float> px, py, pz, vy;
+    std::vector<uint32_t> rng;
+    bool needsSpawn = true;
+    uint32_t spawnSeed = RANDOM_SEED;
+    uint32_t spawns = 0;   // respawnAll() calls served, so each one draws new numbers
+
+    std::vector<int> chunkHits;
+    std::vector<glm::vec2> chunkSamples;
+
+    template <class For>
+    DropletImpacts run(float dt, const DropletParams& params, For&& forChunks)
+    {
+        DropletImpacts impacts;
+        if (n == 0) return impacts;
+
+        const size_t chunks = (n + PARTICLE_GRAIN - 1) / PARTICLE_GRAIN;
+        chunkHits.assign(chunks, 0);
+        chunkSamples.assign(chunks * PARTICLE_IMPACT_SAMPLES, glm::vec2(0.0f));
+
+        const bool spawn = needsSpawn;
+        needsSpawn = false;
+        const uint32_t spawnBatch = spawn ? randomSeed(spawnSeed, spawns++) : 0;
+
+        // padded lanes are simulated too (never drawn, never counted), so chunks stay whole vectors
+        const size_t padded = px.size();
+        forChunks(padded, [&](size_t begin, size_t end) {
+            const size_t chunk = begin / PARTICLE_GRAIN;
+            if (spawn)
+                spawnRange(begin, end, params, Random(spawnBatch, (uint32_t)chunk));
+            else
+                chunkHits[chunk] = stepRange(begin, std::min(end, n), end, dt, params, &chunkSamples[chunk * PARTICLE_IMPACT_SAMPLES]);
+        });
+
+        for (size_t c = 0; c < chunks; c++)
+        {
+            impacts.count += chunkHits[c];
+            int kept = std::min(chunkHits[c], PARTICLE_IMPACT_SAMPLES);
+            for (int k = 0; k < kept; k++)
+                impacts.samples.push_back(chunkSamples[c * PARTICLE_IMPACT_SAMPLES + k]);
+        }
+        return impacts;
+    }
+
+    void spawnOne(size_t i, const DropletParams& p)
+    {
+        px[i] = p.origin.x + (randomNext01(rng[i]) * 2.0f - 1.0f) * p.jitter;
+        py[i] = p.origin.y;
+        pz[i] = p.origin.z + (randomNext01(rng[i]) * 2.0f - 1.0f) * p.jitter;
+        vy[i] = -0.2f - randomNext01(rng[i]) * 0.3f;
+    }
+
+    // the whole range at once: x, z and speed as three batch fills of this chunk's generator
+    void spawnRange(size_t begin, size_t end, const DropletParams& p, Random random)
+    {
+        const size_t count = end - begin;
+        std::vector<float> values(3 * count);
+        random.fill01(values.data(), count, p.origin.x - p.jitter, p.origin.x + p.jitter);
+        random.fill01(values.data() + count, count, p.origin.z - p.jitter, p.origin.z + p.jitter);
+        random.fill01(values.data() + 2 * count, count, -0.5f, -0.2f);
+
+        std::copy(values.begin(), values.begin() + count, px.begin() + begin);
+        std::fill(py.begin() + begin, py.begin() + end, p.origin.y);
+        std::copy(values.begin() + count, values.begin() + 2 * count, pz.begin() + begin);
+        std::copy(values.begin() + 2 * count, values.end(), vy.begin() + begin);
+    }
+
+    // [begin, end) is a whole number of SIMD steps; lanes at or past 'live' don't report impacts.
+    // returns the impacts of live lanes, the first PARTICLE_IMPACT_SAMPLES positions go to 'samples'
+    int stepRange(size_t begin, size_t live, size_t end, float dt, const DropletParams& p, glm::vec2* samples)
+    {
+        int hits = 0;
+        const float r2 = p.captureRadius * p.captureRadius;
+        size_t i = begin;
+
+#if defined(PARTICLES_AVX2)
+        const __m256 vdt = _mm256_set1_ps(dt);
+        const __m256 vg = _mm256_set1_ps(p.gravity * dt);
+        const __m256 surface = _mm256_set1_ps(p.captureY);
+        const __m256 killY = _mm256_set1_ps(p.killY);
+        const __m256 cx = _mm256_set1_ps(p.captureCenter.x);
+        const __m256 cz = _mm256_set1_ps(p.captureCenter.y);
+        const __m256 vr2 = _mm256_set1_ps(r2);
+        const __m256 ox = _mm256_set1_ps(p.origin.x), oy = _mm256_set1_ps(p.origin.y), oz = _mm256_set1_ps(p.origin.z);
+        const __m256 jit = _mm256_set1_ps(p.jitter);
+        const __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f);
+        const __m256 unit = _mm256_set1_ps(1.0f / 16777216.0f);
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 v = _mm256_sub_ps(_mm256_loadu_ps(&vy[i]), vg);
+            __m256 x = _mm256_loadu_ps(&px[i]);
+            __m256 y = _mm256_add_ps(_mm256_loadu_ps(&py[i]), _mm256_mul_ps(v, vdt));
+            __m256 z = _mm256_loadu_ps(&pz[i]);
+
+            __m256 dx = _mm256_sub_ps(x, cx), dz = _mm256_sub_ps(z, cz);
+            __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz));
+            __m256 captured = _mm256_and_ps(_mm256_cmp_ps(y, surface, _CMP_LE_OQ), _mm256_cmp_ps(d2, vr2, _CMP_LE_OQ));
+            __m256 respawn = _mm256_or_ps(captured, _mm256_cmp_ps(y, killY, _CMP_LT_OQ));
+
+            int capturedMask = _mm256_movemask_ps(captured);
+            if (i + 8 > live) capturedMask &= (1 << (int)(live > i ? live - i : 0)) - 1;
+            if (capturedMask)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    if (!((capturedMask >> k) & 1)) continue;
+                    if (hits < PARTICLE_IMPACT_SAMPLES) samples[hits] = glm::vec2(px[i + k], pz[i + k]);
+                    hits++;
+                }
+            }
+
+            if (_mm256_movemask_ps(respawn))
+            {
+                // three draws per lane, used only where 'respawn' is set
+                __m256i s = _mm256_loadu_si256((const __m256i*)&rng[i]);
+                __m256 r[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    s = randomHash8(s);
+                    r[k] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(s, 8)), unit);
+                }
+                __m256i keep = _mm256_loadu_si256((const __m256i*)&rng[i]);
+                s = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(keep), _mm256_castsi256_ps(s), respawn));
+                _mm256_storeu_si256((__m256i*)&rng[i], s);
+
+                __m256 nx = _mm256_add_ps(ox, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(r[0], two), one), jit));
+                __m256 nz = _mm256_add_ps(oz, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(r[1], two), one), jit));
+                __m256 nv = _mm256_sub_ps(_mm256_set1_ps(-0.2f), _mm256_mul_ps(r[2], _mm256_set1_ps(0.3f)));
+                x = _mm256_blendv_ps(x, nx, respawn);
+                y = _mm256_blendv_ps(y, oy, respawn);
+                z = _mm256_blendv_ps(z, nz, respawn);
+                v = _mm256_blendv_ps(v, nv, respawn);
+                _mm256_storeu_ps(&px[i], x);
+                _mm256_storeu_ps(&pz[i], z);
+            }
+            _mm256_storeu_ps(&py[i], y);
+            _mm256_storeu_ps(&vy[i], v);
+        }
+#elif defined(PARTICLES_SSE)
+        const __m128 vdt = _mm_set1_ps(dt);
+        const __m128 vg = _mm_set1_ps(p.gravity * dt);
+        const __m128 surface = _mm_set1_ps(p.captureY);
+        const __m128 killY = _mm_set1_ps(p.killY);
+        const __m128 cx = _mm_set1_ps(p.captureCenter.x);
+        const __m128 cz = _mm_set1_ps(p.captureCenter.y);
+        const __m128 vr2 = _mm_set1_ps(r2);
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 v = _mm_sub_ps(_mm_loadu_ps(&vy[i]), vg);
+            __m128 y = _mm_add_ps(_mm_loadu_ps(&py[i]), _mm_mul_ps(v, vdt));
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(&px[i]), cx);
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(&pz[i]), cz);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+            __m128 captured = _mm_and_ps(_mm_cmple_ps(y, surface), _mm_cmple_ps(d2, vr2));
+            __m128 respawn = _mm_or_ps(captured, _mm_cmplt_ps(y, killY));
+            _mm_storeu_ps(&py[i], y);
+            _mm_storeu_ps(&vy[i], v);
+
+            int respawnMask = _mm_movemask_ps(respawn);
+            if (!respawnMask) continue;
+
+            // respawns are rare (a few per frame in thousands), the scalar path handles them
+            int capturedMask = _mm_movemask_ps(captured);
+            for (int k = 0; k < 4; k++)
+            {
+                if (!((respawnMask >> k) & 1)) continue;
+                if (((capturedMask >> k) & 1) && i + k < live)
+                {
+                    if (hits < PARTICLE_IMPACT_SAMPLES) samples[hits] = glm::vec2(px[i + k], pz[i + k]);
+                    hits++;
+                }
+                spawnOne(i + k, p);
+            }
+        }
+#endif
+        for (; i < end; i++)
+        {
+            vy[i] -= p.gravity * dt;
+            py[i] += vy[i] * dt;
+
+            float dx = px[i] - p.captureCenter.x, dz = pz[i] - p.captureCenter.y;
+            bool captured = py[i] <= p.captureY && dx * dx + dz * dz <= r2;
+            if (captured && i < live)
+            {
+                if (hits < PARTICLE_IMPACT_SAMPLES) samples[hits] = glm::vec2(px[i], pz[i]);
+                hits++;
+            }
+            if (captured || py[i] < p.killY) spawnOne(i, p);
+        }
+        return hits;
+    }
+};
+
+// Draws a DropletSystem as instanced boxes (basic.vert, PARTICLE feature).
+// the SoA position streams are uploaded as they are into three buffers, one float attribute
+// each, so there is no repacking on the CPU; all droplets share one object record (color).
+class ParticleRenderer {
+public:
+    // cubeVBO: unit cube, position + normal (6 floats)
+    void init(unsigned int cubeVBO)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(4, streams);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        const unsigned int attribs[4] = { PARTICLE_ATTRIB_X, PARTICLE_ATTRIB_Y, PARTICLE_ATTRIB_Z, PARTICLE_ATTRIB_VY };
+        for (int k = 0; k < 4; k++)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, streams[k]);
+            glVertexAttribPointer(attribs[k], 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+            glEnableVertexAttribArray(attribs[k]);
+            glVertexAttribDivisor(attribs[k], 1);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // per frame, while recording; [lo, hi] is a world box holding every droplet
+    void submit(const DropletSystem& system, ObjectBuffer& objects, FrustumCuller& culler,
+        const glm::vec3& color, const glm::vec3& lo, const glm::vec3& hi)
+    {
+        const float* data[4] = { system.x(), system.y(), system.z(), system.velocityY() };
+        submit(system.size(), data, objects, culler, color, lo, hi);
+    }
+
+    // same from a copy of the streams (x, y, z, vy; 'droplets' entries each), e.g. a snapshot
+    // published by a simulation running on another thread
+    void submit(size_t droplets, const float* const data[4], ObjectBuffer& objects, FrustumCuller& culler,
+        const glm::vec3& color, const glm::vec3& lo, const glm::vec3& hi)
+    {
+        count = (int)droplets;
+        object = objects.push(glm::mat4(1.0f), color);
+        bounds = culler.add(glm::mat4(1.0f), lo, hi);
+
+        const size_t bytes = droplets * sizeof(float);
+        for (int k = 0; k < 4; k++)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, streams[k]);
+            glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);   // orphan
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data[k]);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // expects the object buffer uploaded + bound; 'feature' selects the PARTICLE variant.
+    // lag: seconds the drawn frame is behind the last tick (droplets are moved back along vy)
+    void draw(ShaderVariants& shaders, unsigned int feature, UniformKey objectIndex,
+        const FrustumCuller& culler, const glm::vec3& size, float lag = 0.0f)
+    {
+        if (count == 0 || !culler.visible(bounds)) return;
+
+        Shader& shader = shaders.get(feature);
+        shader.use();
+        shader.setInt(objectIndex, object);
+        shader.setVec3(U_PARTICLE_SIZE, size);
+        shader.setFloat(U_PARTICLE_LAG, lag);
+
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, count);
+        glBindVertexArray(0);
+    }
+
+    void hide()
+    {
+        count = 0;
+    }
+
+private:
+    // hashed at compile time
+    static constexpr UniformKey U_PARTICLE_SIZE{ "uParticleSize" };
+    static constexpr UniformKey U_PARTICLE_LAG{ "uParticleLag" };
+
+    unsigned int VAO = 0;
+    unsigned int streams[4] = { 0, 0, 0, 0 };
+    int count = 0;
+    int object = -1;
+    int bounds = -1;
+};
+
+// --bench particles: update cost from 60 to 10M droplets, on 1 thread and on all of them
+static void runParticleBenchmark()
+{
+    DropletParams params;
+    params.origin = glm::vec3(0.0f, 2.2f, -2.7f);
+    params.jitter = 0.12f;
+    params.gravity = 6.5f;
+    params.captureY = 0.2f;
+    params.captureCenter = glm::vec2(0.0f, -2.4f);
+    params.captureRadius = 0.4f;
+    params.killY = -1.0f;
+
+    const size_t counts[] = { 60, 600, 6000, 60000, 600000, 6000000, 10000000 };
+    const float dt = 1.0f / 60.0f;
+
+#if defined(PARTICLES_AVX2)
+    const char* isa = "AVX2";
+#elif defined(PARTICLES_SSE)
+    const char* isa = "SSE2";
+#else
+    const char* isa = "scalar";
+#endif
+    std::cout << "droplet update benchmark (" << isa << ", " << hardwareThreads() << " hardware threads)" << std::endl;
+    std::cout << std::setw(10) << "droplets" << std::setw(9) << "threads"
+        << std::setw(14) << "ns/droplet" << std::setw(10) << "speedup" << std::endl;
+
+    for (size_t count : counts)
+    {
+        double single = 0.0;
+        forEachThreadCount([&](unsigned int threads, ThreadPool* pool) {
+            DropletSystem system;
+            system.init(count, 1337);
+            auto step = [&] {
+                if (pool) system.update(dt, params, *pool);
+                else      system.update(dt, params);
+            };
+            step();   // spawn
+
+            // enough steps for ~50M droplet updates, at least 3
+            const int steps = (int)std::max<size_t>(3, 50000000 / count);
+            for (int s = 0; s < std::min(steps, 3); s++) step();   // warm up
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (int s = 0; s < steps; s++) step();
+            auto t1 = std::chrono::steady_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / ((double)steps * count);
+            if (threads == 1) single = ns;
+            std::cout << std::setw(10) << count << std::setw(9) << threads
+                << std::setw(14) << std::fixed << std::setprecision(3) << ns
+                << std::setw(9) << std::setprecision(2) << single / ns << "x" << std::endl;
+        });
+    }
+}
+
+#endif
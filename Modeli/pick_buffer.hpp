@@ -0,0 +1,160 @@
+#ifndef PICK_BUFFER_H
+#define PICK_BUFFER_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+// readbacks in flight; a result is normally there one or two frames after its pass.
+// a pick asked for while all of them are still pending is dropped
+const int PICK_READBACKS = 4;
+
+// what one ID pass found under its pixel
+struct PickResult {
+    uint32_t id = 0;                     // pick id of the record drawn there, 0 = nothing
+    glm::vec3 point = glm::vec3(0.0f);   // world position of the pixel (id != 0 only)
+    int frames = 0;                      // poll() calls it took to arrive
+};
+
+// Pixel-exact picking on the GPU, whatever the geometry (imported meshes, alpha-tested icons).
+// an ID pass draws the frame once more with the PICK shader variants: they write the pick id of
+// every object record (ObjectBuffer::pickId) into an R32UI attachment. a 1x1 scissor keeps the
+// pass to the pixel under the cursor, so it costs the vertex work and next to no raster.
+// that pixel and its depth are copied into a pixel-pack buffer and fenced; poll() maps the
+// buffer only once the fence has signalled, so nothing ever waits for the GPU.
+class PickBuffer {
+public:
+    void init()
+    {
+        glGenFramebuffers(1, &fbo);
+        glGenRenderbuffers(1, &idTarget);
+        glGenRenderbuffers(1, &depthTarget);
+
+        // id + depth of one pixel each
+        for (Slot& s : slots)
+        {
+            glGenBuffers(1, &s.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, 2 * sizeof(uint32_t), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // draws drawIds() into pixel (x, y) of a width x height target (GL window coordinates,
+    // origin bottom-left) and queues its readback. VP: the frame's view-projection, to turn
+    // the depth back into a world position. false if the pick was dropped
+    template<class F>
+    bool pick(int width, int height, int x, int y, const glm::mat4& VP, F&& drawIds)
+    {
+        if (inFlight == PICK_READBACKS || x < 0 || y < 0 || x >= width || y >= height) return false;
+        resize(width, height);
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+        glEnable(GL_DEPTH_TEST);   // nearest surface wins even with the depth test toggled off
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, y, 1, 1);
+
+        // integer attachment: glClear's float color is undefined on it (and blending is off)
+        const GLuint nothing = 0;
+        const GLfloat farthest = 1.0f;
+        glClearBufferuiv(GL_COLOR, 0, &nothing);
+        glClearBufferfv(GL_DEPTH, 0, &farthest);
+        drawIds();
+
+        Slot& s = slots[(oldest + inFlight) % PICK_READBACKS];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glReadPixels(x, y, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, (void*)0);
+        glReadPixels(x, y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, (void*)sizeof(uint32_t));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        s.inverseVP = glm::inverse(VP);
+        s.ndc = glm::vec2(2.0f * (x + 0.5f) / width - 1.0f, 2.0f * (y + 0.5f) / height - 1.0f);
+        s.issued = polls;
+        inFlight++;
+
+        glDisable(GL_SCISSOR_TEST);
+        if (!depth) glDisable(GL_DEPTH_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        return true;
+    }
+
+    // once per frame: true with the oldest pick in 'result' if the GPU has finished it; never waits
+    bool poll(PickResult& result)
+    {
+        polls++;
+        if (inFlight == 0) return false;
+
+        Slot& s = slots[oldest];
+        if (glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(s.fence);
+        s.fence = nullptr;
+        oldest = (oldest + 1) % PICK_READBACKS;
+        inFlight--;
+
+        uint32_t data[2] = { 0, 0 };
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+        if (const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(data), GL_MAP_READ_BIT))
+        {
+            std::memcpy(data, mapped, sizeof(data));
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        float depth;
+        std::memcpy(&depth, &data[1], sizeof(depth));
+        result = PickResult();
+        result.id = data[0];
+        result.frames = polls - s.issued;
+        if (result.id != 0)
+        {
+            glm::vec4 p = s.inverseVP * glm::vec4(s.ndc.x, s.ndc.y, depth * 2.0f - 1.0f, 1.0f);
+            result.point = glm::vec3(p) / p.w;
+        }
+        return true;
+    }
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        glm::mat4 inverseVP = glm::mat4(1.0f);
+        glm::vec2 ndc = glm::vec2(0.0f);   // center of the picked pixel
+        int issued = 0;                    // 'polls' when the pass was drawn
+    };
+
+    GLuint fbo = 0, idTarget = 0, depthTarget = 0;
+    int targetWidth = 0, targetHeight = 0;
+    Slot slots[PICK_READBACKS];
+    int oldest = 0, inFlight = 0;
+    int polls = 0;
+
+    // the targets follow the framebuffer size, so a pixel maps 1:1 with the same projection
+    void resize(int width, int height)
+    {
+        if (width == targetWidth && height == targetHeight) return;
+        targetWidth = width;
+        targetHeight = height;
+
+        glBindRenderbuffer(GL_RENDERBUFFER, idTarget);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthTarget);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, idTarget);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthTarget);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+};
+
+#endif
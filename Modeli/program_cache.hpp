@@ -0,0 +1,185 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <GL/glew.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+
+// directory (relative to the working dir) holding linked program binaries
+#ifndef PROGRAM_CACHE_DIR
+#define PROGRAM_CACHE_DIR "shader_cache"
+#endif
+
+// 64-bit FNV-1a, used as the cache key of a program's sources
+constexpr uint64_t sourceHash(std::string_view text, uint64_t h = 14695981039346656037ull)
+{
+    for (char c : text)
+    {
+        h ^= (uint8_t)c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// On-disk cache of linked programs (glGetProgramBinary / glProgramBinary).
+// an entry is keyed by the hash of the sources and only accepted when it was written
+// by the same driver (vendor/renderer/version); anything else falls back to compiling.
+class ProgramCache {
+public:
+    static bool supported()
+    {
+        static int state = -1;
+        if (state < 0)
+        {
+            GLint formats = 0;
+            if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            state = formats > 0 ? 1 : 0;
+        }
+        return state == 1;
+    }
+
+    // built from the per-file hashes (known at compile time for embedded sources)
+    // plus the injected #define lines
+    static constexpr uint64_t key(uint64_t vertexHash, uint64_t fragmentHash, std::string_view defines = {})
+    {
+        uint64_t h = vertexHash;
+        h ^= fragmentHash + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        return sourceHash(defines, h);
+    }
+
+    // must be set before linking, otherwise some drivers refuse to hand the binary out
+    static void prepare(GLuint program)
+    {
+        if (supported())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // tries to link 'program' from the cache; false means "compile from source"
+    static bool load(GLuint program, uint64_t sourceKey)
+    {
+        if (!supported()) return false;
+
+        std::ifstream in(path(sourceKey), std::ios::binary);
+        if (!in) return false;
+
+        uint32_t magic = 0, version = 0, driverLength = 0, format = 0, length = 0;
+        uint64_t storedKey = 0;
+        in.read((char*)&magic, sizeof(magic));
+        in.read((char*)&version, sizeof(version));
+        in.read((char*)&storedKey, sizeof(storedKey));
+        in.read((char*)&driverLength, sizeof(driverLength));
+        if (!in || magic != MAGIC || version != VERSION || storedKey != sourceKey || driverLength > 4096)
+            return false;
+
+        std::string storedDriver(driverLength, '\0');
+        in.read(&storedDriver[0], driverLength);
+        in.read((char*)&format, sizeof(format));
+        in.read((char*)&length, sizeof(length));
+        if (!in || storedDriver != driver())
+            return false;
+
+        // a truncated or corrupt entry must not decide how much we allocate
+        const std::streampos body = in.tellg();
+        in.seekg(0, std::ios::end);
+        const std::streamoff remaining = in.tellg() - body;
+        in.seekg(body);
+        if (!in || length == 0 || (std::streamoff)length != remaining)
+            return false;
+
+        std::vector<char> binary(length);
+        in.read(binary.data(), length);
+        if (!in) return false;
+
+        glProgramBinary(program, (GLenum)format, binary.data(), (GLsizei)length);
+
+        // the driver may still reject it (e.g. after an update that kept the version string)
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            std::cout << "SHADER CACHE: stale entry " << path(sourceKey) << ", recompiling" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // stores a successfully linked program
+    static void store(GLuint program, uint64_t sourceKey)
+    {
+        if (!supported()) return;
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code ec;
+        std::filesystem::create_directories(PROGRAM_CACHE_DIR, ec);
+
+        // written next to the entry and renamed over it once complete, so an interrupted
+        // write never leaves a half entry behind (a leftover .tmp is just overwritten later)
+        const std::string target = path(sourceKey);
+        const std::string temp = target + ".tmp";
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+
+        const std::string drv = driver();
+        uint32_t magic = MAGIC, version = VERSION;
+        uint32_t driverLength = (uint32_t)drv.size(), fmt = (uint32_t)format, len = (uint32_t)length;
+        out.write((const char*)&magic, sizeof(magic));
+        out.write((const char*)&version, sizeof(version));
+        out.write((const char*)&sourceKey, sizeof(sourceKey));
+        out.write((const char*)&driverLength, sizeof(driverLength));
+        out.write(drv.data(), drv.size());
+        out.write((const char*)&fmt, sizeof(fmt));
+        out.write((const char*)&len, sizeof(len));
+        out.write(binary.data(), length);
+        out.close();
+        if (!out)
+        {
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+
+        std::filesystem::rename(temp, target, ec);
+        if (ec) std::filesystem::remove(temp, ec);
+    }
+
+private:
+    static const uint32_t MAGIC = 0x42504752; // "RGPB"
+    static const uint32_t VERSION = 2;
+
+    static const std::string& driver()
+    {
+        static std::string d;
+        if (d.empty())
+        {
+            auto str = [](GLenum name) {
+                const GLubyte* s = glGetString(name);
+                return s ? std::string((const char*)s) : std::string("?");
+            };
+            d = str(GL_VENDOR) + "|" + str(GL_RENDERER) + "|" + str(GL_VERSION);
+        }
+        return d;
+    }
+
+    static std::string path(uint64_t sourceKey)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)sourceKey);
+        return std::string(PROGRAM_CACHE_DIR) + "/" + name;
+    }
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__AVX2__)
+#define RANDOM_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RANDOM_SSE 1
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#endif
+
+// Random numbers without std::rand: nothing shared, nothing locked, reproducible from one seed.
+//  - per element: randomHash() is lowbias32, the hash droplets_update.vert uses. randomSeed()
+//    derives element i's state from the seed alone (any element, any order, any thread) and
+//    randomNext01() steps it exactly like the shader's next01(), so a CPU and a GPU simulation
+//    seeded the same way draw the same numbers.
+//  - Random: xoshiro128+ on RANDOM_LANES interleaved streams, for bulk draws. fill01() writes
+//    whole arrays 8 (AVX2) or 4 (SSE2) at a time; next01() hands out the same sequence one by
+//    one. give every chunk of parallel work its own (seed, stream), so the result doesn't
+//    depend on which thread ran it.
+
+const uint32_t RANDOM_SEED = 1337;   // default seed of the whole program
+const int RANDOM_LANES = 8;          // streams per Random (fixed, so results don't depend on the ISA)
+
+inline uint32_t randomHash(uint32_t x)
+{
+    x ^= x >> 16; x *= 0x7FEB352Du;
+    x ^= x >> 15; x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// top 24 bits -> [0, 1)
+inline float randomUnit(uint32_t bits)
+{
+    return (float)(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// well-mixed, never 0 state for element 'index' of 'seed'
+inline uint32_t randomSeed(uint32_t seed, uint64_t index)
+{
+    uint32_t h = randomHash(seed ^ (uint32_t)(index * 0x9E3779B9u) ^ (uint32_t)(index >> 32));
+    return h ? h : 0x6D2B79F5u;
+}
+
+// one step of a per-element stream (same as next01() in droplets_update.vert)
+inline float randomNext01(uint32_t& state)
+{
+    state = randomHash(state);
+    return randomUnit(state);
+}
+
+#if defined(RANDOM_AVX2)
+inline __m256i randomHash8(__m256i x)
+{
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x7FEB352Du));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x846CA68Bu));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    return x;
+}
+#endif
+
+#if defined(RANDOM_AVX2) || defined(RANDOM_SSE)
+// 32-bit lane multiply; SSE2 only has 32x32->64 on the even lanes
+inline __m128i randomMul32(__m128i a, __m128i b)
+{
+#if defined(__SSE4_1__)
+    return _mm_mullo_epi32(a, b);
+#else
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+inline __m128i randomHash4(__m128i x)
+{
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    x = randomMul32(x, _mm_set1_epi32((int)0x7FEB352Du));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+    x = randomMul32(x, _mm_set1_epi32((int)0x846CA68Bu));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    return x;
+}
+#endif
+
+class Random {
+public:
+    explicit Random(uint32_t seed = RANDOM_SEED, uint32_t stream = 0)
+    {
+        reseed(seed, stream);
+    }
+
+    void reseed(uint32_t seed, uint32_t stream = 0)
+    {
+        for (int k = 0; k < 4; k++)
+            for (int l = 0; l < RANDOM_LANES; l++)
+                s[k][l] = randomSeed(seed, ((uint64_t)stream << 8) | (uint64_t)(l * 4 + k));
+        used = RANDOM_LANES;
+    }
+
+    uint32_t nextBits()
+    {
+        if (used == RANDOM_LANES)
+        {
+            step(buffer);
+            used = 0;
+        }
+        return buffer[used++];
+    }
+
+    float next01()
+    {
+        return randomUnit(nextBits());
+    }
+
+    float uniform(float lo, float hi)
+    {
+        return lo + (hi - lo) * next01();
+    }
+
+    // n uniform floats in [lo, hi): the same numbers n calls of uniform() would give
+    void fill01(float* out, size_t n, float lo = 0.0f, float hi = 1.0f)
+    {
+        size_t i = 0;
+        while (i < n && used < RANDOM_LANES) out[i++] = uniform(lo, hi);
+
+        const float scale = (hi - lo) * (1.0f / 16777216.0f);
+        for (; i + RANDOM_LANES <= n; i += RANDOM_LANES)
+        {
+            uint32_t bits[RANDOM_LANES];
+            step(bits);
+#if defined(RANDOM_AVX2)
+            __m256 f = _mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_loadu_si256((const __m256i*)bits), 8));
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_set1_ps(lo), _mm256_mul_ps(f, _mm256_set1_ps(scale))));
+#elif defined(RANDOM_SSE)
+            for (int h = 0; h < RANDOM_LANES; h += 4)
+            {
+                __m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_loadu_si128((const __m128i*)(bits + h)), 8));
+                _mm_storeu_ps(out + i + h, _mm_add_ps(_mm_set1_ps(lo), _mm_mul_ps(f, _mm_set1_ps(scale))));
+            }
+#else
+            for (int l = 0; l < RANDOM_LANES; l++) out[i + l] = lo + (float)(bits[l] >> 8) * scale;
+#endif
+        }
+
+        for (; i < n; i++) out[i] = uniform(lo, hi);
+    }
+
+private:
+    uint32_t s[4][RANDOM_LANES];
+    uint32_t buffer[RANDOM_LANES];
+    int used = RANDOM_LANES;
+
+    // one xoshiro128+ step of every lane
+    void step(uint32_t* out)
+    {
+#if defined(RANDOM_AVX2)
+        __m256i s0 = _mm256_loadu_si256((const __m256i*)s[0]), s1 = _mm256_loadu_si256((const __m256i*)s[1]);
+        __m256i s2 = _mm256_loadu_si256((const __m256i*)s[2]), s3 = _mm256_loadu_si256((const __m256i*)s[3]);
+        _mm256_storeu_si256((__m256i*)out, _mm256_add_epi32(s0, s3));
+        __m256i t = _mm256_slli_epi32(s1, 9);
+        s2 = _mm256_xor_si256(s2, s0); s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2); s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+        _mm256_storeu_si256((__m256i*)s[0], s0); _mm256_storeu_si256((__m256i*)s[1], s1);
+        _mm256_storeu_si256((__m256i*)s[2], s2); _mm256_storeu_si256((__m256i*)s[3], s3);
+#elif defined(RANDOM_SSE)
+        for (int h = 0; h < RANDOM_LANES; h += 4)
+        {
+            __m128i s0 = _mm_loadu_si128((const __m128i*)(s[0] + h)), s1 = _mm_loadu_si128((const __m128i*)(s[1] + h));
+            __m128i s2 = _mm_loadu_si128((const __m128i*)(s[2] + h)), s3 = _mm_loadu_si128((const __m128i*)(s[3] + h));
+            _mm_storeu_si128((__m128i*)(out + h), _mm_add_epi32(s0, s3));
+            __m128i t = _mm_slli_epi32(s1, 9);
+            s2 = _mm_xor_si128(s2, s0); s3 = _mm_xor_si128(s3, s1);
+            s1 = _mm_xor_si128(s1, s2); s0 = _mm_xor_si128(s0, s3);
+            s2 = _mm_xor_si128(s2, t);
+            s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+            _mm_storeu_si128((__m128i*)(s[0] + h), s0); _mm_storeu_si128((__m128i*)(s[1] + h), s1);
+            _mm_storeu_si128((__m128i*)(s[2] + h), s2); _mm_storeu_si128((__m128i*)(s[3] + h), s3);
+        }
+#else
+        for (int l = 0; l < RANDOM_LANES; l++)
+        {
+            out[l] = s[0][l] + s[3][l];
+            uint32_t t = s[1][l] << 9;
+            s[2][l] ^= s[0][l]; s[3][l] ^= s[1][l];
+            s[1][l] ^= s[2][l]; s[0][l] ^= s[3][l];
+            s[2][l] ^= t;
+            s[3][l] = (s[3][l] << 11) | (s[3][l] >> 21);
+        }
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,738 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "random.hpp"
+#include "aabb_tree.hpp"
+#include "parallel.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cfloat>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <numeric>
+#include <algorithm>
+
+#if defined(__AVX__)
+#define RAYCAST_SSE 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYCAST_SSE 1
+#include <emmintrin.h>
+#endif
+
+// Ray casting against the scene's triangles (picking, interaction).
+//  - Bvh4: 4-wide bounding volume hierarchy over boxes. built as a binary tree with binned
+//    SAH (surface area heuristic) splits, then collapsed so every node holds 4 child boxes in
+//    SoA: one SSE register per slab, 4 children tested at once (AVX builds use the same path,
+//    4 children is the natural width). traversal visits hit children nearest first.
+//  - TriangleBVH: one mesh, built once at load time from its triangles
+//  - RayScene: placements of meshes (instances) in a DynamicAABBTree (aabb_tree.hpp) on top,
+//    so a mesh placed many times is stored once. the ray is moved into each instance's
+//    space instead of the triangles into the world.
+
+const int BVH_BINS = 16;              // SAH candidates per axis
+const int BVH_MAX_DEPTH = 48;         // deeper than this: plain median splits
+const float BVH_TRAVERSAL_COST = 1.0f;   // node visit vs. one triangle test
+
+// 4 child boxes of one node, slot k: box in min*/max*[k]
+//   count[k] > 0: leaf, primitives order[child[k] .. child[k] + count[k])
+//   count[k] == 0, child[k] >= 0: inner node child[k]
+//   child[k] < 0: empty slot
+struct alignas(16) BvhNode4 {
+    float minX[4], minY[4], minZ[4];
+    float maxX[4], maxY[4], maxZ[4];
+    int32_t child[4];
+    uint32_t count[4];
+};
+
+class Bvh4 {
+public:
+    std::vector<BvhNode4> nodes;     // nodes[0] is the root
+    std::vector<uint32_t> order;     // primitive index of every leaf entry
+
+    // boxes lo[i]..hi[i] of 'count' primitives, at most maxLeaf per leaf
+    void build(const glm::vec3* lo, const glm::vec3* hi, size_t count, uint32_t maxLeaf)
+    {
+        nodes.clear();
+        order.clear();
+        if (count == 0) return;
+
+        refs.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            for (int a = 0; a < 3; a++) { refs[i].box.lo[a] = lo[i][a]; refs[i].box.hi[a] = hi[i][a]; }
+            refs[i].id = (uint32_t)i;
+        }
+
+        tree.clear();
+        tree.reserve(count);
+        BuildNode root;
+        root.begin = 0;
+        root.count = (uint32_t)count;
+        tree.push_back(root);
+
+        struct Pending { int node; int depth; };
+        std::vector<Pending> stack = { { 0, 0 } };
+        while (!stack.empty())
+        {
+            const Pending p = stack.back();
+            stack.pop_back();
+
+            int left, right;
+            if (split(p.node, p.depth, maxLeaf, left, right))
+            {
+                stack.push_back({ left, p.depth + 1 });
+                stack.push_back({ right, p.depth + 1 });
+            }
+        }
+
+        order.resize(count);
+        for (size_t i = 0; i < count; i++) order[i] = refs[i].id;
+        nodes.reserve(tree.size() / 2 + 1);
+        collapse(0);
+        tree = std::vector<BuildNode>();
+        refs = std::vector<Ref>();
+    }
+
+    bool empty() const
+    {
+        return nodes.empty();
+    }
+
+    glm::vec3 boundsMin() const
+    {
+        return rootLo;
+    }
+
+    glm::vec3 boundsMax() const
+    {
+        return rootHi;
+    }
+
+    // closest-first walk along o + t*d, t in [0, tMax]. leaf(first, count, tMax) tests
+    // order[first .. first + count) and shortens tMax to what it hit; subtrees starting
+    // beyond tMax are skipped.
+    template<class F>
+    void traverse(const glm::vec3& o, const glm::vec3& d, float& tMax, F&& leaf) const
+    {
+        if (nodes.empty()) return;
+
+        // slabs as (box - o) * inv; a 0 component becomes a huge one of the same sign, no NaNs
+        glm::vec3 inv;
+        for (int a = 0; a < 3; a++)
+        {
+            float c = d[a];
+            if (std::fabs(c) < 1e-30f) c = c < 0.0f ? -1e-30f : 1e-30f;
+            inv[a] = 1.0f / c;
+        }
+
+        struct Entry { int32_t child; uint32_t count; float t; };
+        Entry stack[256];
+        int top = 0;
+        stack[top++] = { 0, 0, 0.0f };
+
+#if defined(RAYCAST_SSE)
+        const __m128 ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y), oz = _mm_set1_ps(o.z);
+        const __m128 ix = _mm_set1_ps(inv.x), iy = _mm_set1_ps(inv.y), iz = _mm_set1_ps(inv.z);
+#endif
+        while (top > 0)
+        {
+            const Entry e = stack[--top];
+            if (e.t > tMax) continue;
+            if (e.count > 0)
+            {
+                leaf((uint32_t)e.child, e.count, tMax);
+                continue;
+            }
+
+            const BvhNode4& n = nodes[e.child];
+            float tNear[4];
+            int mask;
+#if defined(RAYCAST_SSE)
+            const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minX), ox), ix);
+            const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxX), ox), ix);
+            const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minY), oy), iy);
+            const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxY), oy), iy);
+            const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.minZ), oz), iz);
+            const __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(n.maxZ), oz), iz);
+            __m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+                _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+            __m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+                _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(tMax)));
+            mask = _mm_movemask_ps(_mm_cmple_ps(enter, exit));
+            _mm_storeu_ps(tNear, enter);
+#else
+            mask = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                const float x0 = (n.minX[k] - o.x) * inv.x, x1 = (n.maxX[k] - o.x) * inv.x;
+                const float y0 = (n.minY[k] - o.y) * inv.y, y1 = (n.maxY[k] - o.y) * inv.y;
+                const float z0 = (n.minZ[k] - o.z) * inv.z, z1 = (n.maxZ[k] - o.z) * inv.z;
+                const float enter = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), 0.0f));
+                const float exit = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::min(std::max(z0, z1), tMax));
+                tNear[k] = enter;
+                if (enter <= exit) mask |= 1 << k;
+            }
+#endif
+            // hit children, farthest pushed first so the nearest is popped next
+            Entry hits[4];
+            int count = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                if (!((mask >> k) & 1) || n.child[k] < 0) continue;
+                Entry h = { n.child[k], n.count[k], tNear[k] };
+                int j = count++;
+                while (j > 0 && hits[j - 1].t < h.t) { hits[j] = hits[j - 1]; j--; }
+                hits[j] = h;
+            }
+            for (int k = 0; k < count; k++) stack[top++] = hits[k];
+        }
+    }
+
+private:
+    // the builder works on plain floats: it runs over millions of boxes
+    struct Box {
+        float lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        void grow(const Box& b)
+        {
+            for (int a = 0; a < 3; a++) { lo[a] = std::min(lo[a], b.lo[a]); hi[a] = std::max(hi[a], b.hi[a]); }
+        }
+
+        float halfArea() const
+        {
+            const float x = std::max(hi[0] - lo[0], 0.0f), y = std::max(hi[1] - lo[1], 0.0f), z = std::max(hi[2] - lo[2], 0.0f);
+            return x * y + y * z + z * x;
+        }
+    };
+
+    // a primitive while building; partitioned in place, so every node's range is contiguous
+    struct Ref {
+        Box box;
+        uint32_t id;
+
+        float centroid(int a) const
+        {
+            return box.lo[a] + box.hi[a];   // doubled, only ever compared
+        }
+    };
+
+    struct BuildNode {
+        Box box;
+        int left = -1, right = -1;
+        uint32_t begin = 0, count = 0;
+    };
+
+    std::vector<BuildNode> tree;          // binary tree, only while building
+    std::vector<Ref> refs;
+    glm::vec3 rootLo = glm::vec3(0.0f), rootHi = glm::vec3(0.0f);
+
+    // bounds of tree[index]; splits it in two unless a leaf is cheaper (binned SAH)
+    bool split(int index, int depth, uint32_t maxLeaf, int& left, int& right)
+    {
+        const uint32_t begin = tree[index].begin, count = tree[index].count;
+        Ref* first = refs.data() + begin;
+        Ref* last = first + count;
+
+        Box bounds, centers;
+        for (const Ref* r = first; r != last; r++)
+        {
+            bounds.grow(r->box);
+            for (int a = 0; a < 3; a++)
+            {
+                centers.lo[a] = std::min(centers.lo[a], r->centroid(a));
+                centers.hi[a] = std::max(centers.hi[a], r->centroid(a));
+            }
+        }
+        tree[index].box = bounds;
+        if (count <= 1) return false;
+
+        // best bin boundary over all three axes; small nodes get a bin per primitive
+        const int bins = std::min(BVH_BINS, (int)count + 1);
+        int bestAxis = -1, bestBin = 0;
+        float bestCost = FLT_MAX;
+        for (int a = 0; a < 3 && depth < BVH_MAX_DEPTH; a++)
+        {
+            const float extent = centers.hi[a] - centers.lo[a];
+            if (extent <= 1e-12f) continue;
+            const float scale = bins / extent;
+
+            uint32_t binCount[BVH_BINS] = {};
+            Box binBox[BVH_BINS];
+            for (const Ref* r = first; r != last; r++)
+            {
+                const int b = std::min(bins - 1, (int)((r->centroid(a) - centers.lo[a]) * scale));
+                binCount[b]++;
+                binBox[b].grow(r->box);
+            }
+
+            // area * count of everything right of each boundary, then sweep from the left
+            float rightCost[BVH_BINS];
+            Box acc;
+            uint32_t accCount = 0;
+            for (int b = bins - 1; b > 0; b--)
+            {
+                acc.grow(binBox[b]);
+                accCount += binCount[b];
+                rightCost[b] = accCount ? acc.halfArea() * accCount : 0.0f;
+            }
+            acc = Box();
+            accCount = 0;
+            for (int b = 0; b < bins - 1; b++)
+            {
+                acc.grow(binBox[b]);
+                accCount += binCount[b];
+                if (accCount == 0 || accCount == count) continue;
+                const float cost = acc.halfArea() * accCount + rightCost[b + 1];
+                if (cost < bestCost) { bestCost = cost; bestAxis = a; bestBin = b; }
+            }
+        }
+
+        // leaf when it fits and the split isn't worth a node visit
+        const float leafCost = (float)count;
+        const float splitCost = BVH_TRAVERSAL_COST + bestCost / std::max(bounds.halfArea(), 1e-30f);
+        if (count <= maxLeaf && (bestAxis < 0 || leafCost <= splitCost)) return false;
+
+        Ref* mid;
+        if (bestAxis >= 0)
+        {
+            const float scale = bins / (centers.hi[bestAxis] - centers.lo[bestAxis]);
+            const float low = centers.lo[bestAxis];
+            mid = std::partition(first, last, [&](const Ref& r) {
+                return std::min(bins - 1, (int)((r.centroid(bestAxis) - low) * scale)) <= bestBin;
+            });
+        }
+        else
+        {
+            // identical centroids or too deep: halves along the widest axis
+            int a = 0;
+            for (int k = 1; k < 3; k++)
+                if (centers.hi[k] - centers.lo[k] > centers.hi[a] - centers.lo[a]) a = k;
+            mid = first + count / 2;
+            std::nth_element(first, mid, last, [&](const Ref& p, const Ref& q) { return p.centroid(a) < q.centroid(a); });
+        }
+        if (mid == first || mid == last) mid = first + count / 2;
+
+        const uint32_t leftCount = (uint32_t)(mid - first);
+        BuildNode l, r;
+        l.begin = begin; l.count = leftCount;
+        r.begin = begin + leftCount; r.count = count - leftCount;
+        left = (int)tree.size();
+        right = left + 1;
+        tree[index].left = left;
+        tree[index].right = right;
+        tree.push_back(l);
+        tree.push_back(r);
+        return true;
+    }
+
+    // binary subtree -> 4-wide node: opens the largest inner child until there are 4
+    int collapse(int b)
+    {
+        int slots[4];
+        int n = 0;
+        const BuildNode& bn = tree[b];
+        if (bn.left < 0) slots[n++] = b;
+        else
+        {
+            slots[n++] = bn.left;
+            slots[n++] = bn.right;
+            while (n < 4)
+            {
+                int open = -1;
+                float area = -1.0f;
+                for (int k = 0; k < n; k++)
+                {
+                    const BuildNode& c = tree[slots[k]];
+                    if (c.left >= 0 && c.box.halfArea() > area) { area = c.box.halfArea(); open = k; }
+                }
+                if (open < 0) break;
+                const BuildNode& c = tree[slots[open]];
+                slots[open] = c.left;
+                slots[n++] = c.right;
+            }
+        }
+        if (b == 0)
+        {
+            rootLo = glm::vec3(bn.box.lo[0], bn.box.lo[1], bn.box.lo[2]);
+            rootHi = glm::vec3(bn.box.hi[0], bn.box.hi[1], bn.box.hi[2]);
+        }
+
+        const int index = (int)nodes.size();
+        nodes.emplace_back();
+        for (int k = 0; k < 4; k++)
+        {
+            BvhNode4& node = nodes[index];
+            node.child[k] = -1;
+            node.count[k] = 0;
+            node.minX[k] = node.minY[k] = node.minZ[k] = FLT_MAX;
+            node.maxX[k] = node.maxY[k] = node.maxZ[k] = -FLT_MAX;
+            if (k >= n) continue;
+
+            const BuildNode& c = tree[slots[k]];
+            node.minX[k] = c.box.lo[0]; node.minY[k] = c.box.lo[1]; node.minZ[k] = c.box.lo[2];
+            node.maxX[k] = c.box.hi[0]; node.maxY[k] = c.box.hi[1]; node.maxZ[k] = c.box.hi[2];
+            if (c.left < 0)
+            {
+                node.child[k] = (int32_t)c.begin;
+                node.count[k] = c.count;
+            }
+            else
+            {
+                const int child = collapse(slots[k]);   // may reallocate 'nodes'
+                nodes[index].child[k] = child;
+            }
+        }
+        return index;
+    }
+};
+
+// One triangle mesh with its Bvh4, in the mesh's own space.
+class TriangleBVH {
+public:
+    // triangle list: 'count' vertices, position = first 3 of every 'stride' floats
+    void build(const float* vertices, size_t count, size_t stride)
+    {
+        std::vector<glm::vec3> positions(count);
+        for (size_t i = 0; i < count; i++)
+            positions[i] = glm::vec3(vertices[i * stride + 0], vertices[i * stride + 1], vertices[i * stride + 2]);
+        std::vector<uint32_t> indices(count);
+        std::iota(indices.begin(), indices.end(), 0u);
+        build(positions.data(), indices.data(), count / 3);
+    }
+
+    // indexed: triangle i is positions[indices[3i .. 3i+2]]
+    void build(const glm::vec3* positions, const uint32_t* indices, size_t triangles)
+    {
+        std::vector<glm::vec3> lo(triangles), hi(triangles);
+        for (size_t i = 0; i < triangles; i++)
+        {
+            const glm::vec3& a = positions[indices[i * 3 + 0]];
+            const glm::vec3& b = positions[indices[i * 3 + 1]];
+            const glm::vec3& c = positions[indices[i * 3 + 2]];
+            lo[i] = glm::min(a, glm::min(b, c));
+            hi[i] = glm::max(a, glm::max(b, c));
+        }
+        bvh.build(lo.data(), hi.data(), triangles, 4);
+
+        // triangles in leaf order, ready for Moeller-Trumbore
+        v0.resize(triangles); e1.resize(triangles); e2.resize(triangles);
+        for (size_t i = 0; i < triangles; i++)
+        {
+            const uint32_t t = bvh.order[i];
+            const glm::vec3& a = positions[indices[t * 3 + 0]];
+            v0[i] = a;
+            e1[i] = positions[indices[t * 3 + 1]] - a;
+            e2[i] = positions[indices[t * 3 + 2]] - a;
+        }
+    }
+
+    size_t triangleCount() const
+    {
+        return v0.size();
+    }
+
+    glm::vec3 boundsMin() const
+    {
+        return bvh.boundsMin();
+    }
+
+    glm::vec3 boundsMax() const
+    {
+        return bvh.boundsMax();
+    }
+
+    // nearest triangle along o + t*d with 0 < t < tMax, both faces count. returns its index
+    // (as given to build) and shortens tMax to the hit, or -1 and leaves tMax alone
+    int intersect(const glm::vec3& o, const glm::vec3& d, float& tMax) const
+    {
+        int hit = -1;
+        bvh.traverse(o, d, tMax, [&](uint32_t first, uint32_t count, float& tBest) {
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                const glm::vec3 p = glm::cross(d, e2[i]);
+                const float det = glm::dot(e1[i], p);
+                if (det == 0.0f) continue;
+                const float inv = 1.0f / det;
+                const glm::vec3 s = o - v0[i];
+                const float u = glm::dot(s, p) * inv;
+                if (u < 0.0f || u > 1.0f) continue;
+                const glm::vec3 q = glm::cross(s, e1[i]);
+                const float v = glm::dot(d, q) * inv;
+                if (v < 0.0f || u + v > 1.0f) continue;
+                const float t = glm::dot(e2[i], q) * inv;
+                if (t > 0.0f && t < tBest)
+                {
+                    tBest = t;
+                    hit = (int)bvh.order[i];
+                }
+            }
+        });
+        return hit;
+    }
+
+private:
+    Bvh4 bvh;
+    std::vector<glm::vec3> v0, e1, e2;
+};
+
+struct RayHit {
+    int instance = -1;   // RayScene::add() id, -1 = nothing
+    int triangle = -1;   // in that instance's mesh
+    float t = FLT_MAX;   // along the ray; world units for a unit direction
+
+    bool hit() const
+    {
+        return instance >= 0;
+    }
+};
+
+// Placed objects of a scene, in a DynamicAABBTree by their world boxes.
+// an instance with a mesh can be hit by rays; one without (addBounds) is only a box, found
+// by the tree queries (culling, proximity). moving an instance moves its leaf, which is
+// free while it stays inside its fat box, so nothing is ever rebuilt.
+class RayScene {
+public:
+    // the mesh is referenced, not copied: it must outlive the scene
+    int add(const TriangleBVH& mesh, const glm::mat4& M, const char* name = "")
+    {
+        return addInstance(&mesh, mesh.boundsMin(), mesh.boundsMax(), M, name);
+    }
+
+    // no triangles: the unit box [-0.5, 0.5] placed by M
+    int addBounds(const glm::mat4& M, const char* name = "")
+    {
+        return addInstance(nullptr, glm::vec3(-0.5f), glm::vec3(0.5f), M, name);
+    }
+
+    void setTransform(int id, const glm::mat4& M)
+    {
+        Instance& inst = instances[id];
+        const glm::vec3 before = inst.box.center();
+        place(inst, M);
+        if (inst.proxy >= 0)
+            tree.move(inst.proxy, inst.box, inst.box.center() - before);
+    }
+
+    // a disabled instance is never found (e.g. hidden this frame)
+    void setEnabled(int id, bool enabled)
+    {
+        Instance& inst = instances[id];
+        if ((inst.proxy >= 0) == enabled) return;
+        if (enabled) inst.proxy = tree.insert(inst.box, id);
+        else
+        {
+            tree.remove(inst.proxy);
+            inst.proxy = -1;
+        }
+    }
+
+    const char* name(int id) const
+    {
+        return id >= 0 && id < (int)instances.size() ? instances[id].name : "";
+    }
+
+    // world box of the instance, as placed last
+    const AABB& bounds(int id) const
+    {
+        return instances[id].box;
+    }
+
+    size_t size() const
+    {
+        return instances.size();
+    }
+
+    const DynamicAABBTree& objects() const
+    {
+        return tree;
+    }
+
+    // nearest triangle along origin + t*dir, t < maxT
+    RayHit cast(const glm::vec3& origin, const glm::vec3& dir, float maxT = FLT_MAX) const
+    {
+        RayHit best;
+        tree.queryRay(origin, dir, maxT, [&](int proxy, float& tBest) {
+            const int id = tree.user(proxy);
+            const Instance& inst = instances[id];
+            if (!inst.mesh) return;
+            // t is the same in both spaces as long as the direction isn't renormalized
+            const glm::vec3 o = glm::vec3(inst.inverse * glm::vec4(origin, 1.0f));
+            const glm::vec3 d = glm::vec3(inst.inverse * glm::vec4(dir, 0.0f));
+            float t = tBest;
+            const int tri = inst.mesh->intersect(o, d, t);
+            if (tri >= 0)
+            {
+                tBest = t;
+                best.instance = id;
+                best.triangle = tri;
+                best.t = t;
+            }
+        });
+        return best;
+    }
+
+    // fn(id) for every instance whose box may be inside the frustum
+    template<class F>
+    void queryFrustum(const Frustum& f, F&& fn) const
+    {
+        tree.queryFrustum(f, [&](int proxy) { fn(tree.user(proxy)); });
+    }
+
+    // fn(id) for every instance whose box may come within 'radius' of 'center'
+    template<class F>
+    void querySphere(const glm::vec3& center, float radius, F&& fn) const
+    {
+        tree.querySphere(center, radius, [&](int proxy) { fn(tree.user(proxy)); return true; });
+    }
+
+private:
+    struct Instance {
+        const TriangleBVH* mesh = nullptr;
+        glm::vec3 localLo = glm::vec3(0.0f), localHi = glm::vec3(0.0f);
+        glm::mat4 inverse = glm::mat4(1.0f);
+        AABB box;              // world box of the local one
+        int proxy = -1;        // leaf in 'tree', -1 = disabled
+        const char* name = "";
+    };
+
+    std::vector<Instance> instances;
+    DynamicAABBTree tree;
+
+    int addInstance(const TriangleBVH* mesh, const glm::vec3& lo, const glm::vec3& hi, const glm::mat4& M, const char* name)
+    {
+        Instance inst;
+        inst.mesh = mesh;
+        inst.localLo = lo;
+        inst.localHi = hi;
+        inst.name = name;
+        place(inst, M);
+        const int id = (int)instances.size();
+        inst.proxy = tree.insert(inst.box, id);
+        instances.push_back(inst);
+        return id;
+    }
+
+    static void place(Instance& inst, const glm::mat4& M)
+    {
+        inst.inverse = glm::inverse(M);
+
+        // world box of the local box: M's columns scaled by the half extents, like boundingSphere
+        const glm::vec3 c = glm::vec3(M * glm::vec4((inst.localLo + inst.localHi) * 0.5f, 1.0f));
+        const glm::vec3 e = (inst.localHi - inst.localLo) * 0.5f;
+        const glm::vec3 r = glm::abs(glm::vec3(M[0])) * e.x + glm::abs(glm::vec3(M[1])) * e.y + glm::abs(glm::vec3(M[2])) * e.z;
+        inst.box = AABB(c - r, c + r);
+    }
+};
+
+// --bench raycast: build time and closest-hit cost on meshes of 20K to 8M triangles, placed
+// once and as 64 instances; the same rays cast from 1 thread up to all of them
+static void runRaycastBenchmark()
+{
+#if defined(RAYCAST_SSE)
+    const char* isa = "SSE";
+#else
+    const char* isa = "scalar";
+#endif
+    std::cout << "ray cast benchmark (" << isa << " node tests, " << hardwareThreads() << " hardware threads)" << std::endl;
+    std::cout << std::setw(12) << "triangles" << std::setw(11) << "instances"
+        << std::setw(12) << "build ms" << std::setw(9) << "threads" << std::setw(12) << "us/ray" << std::setw(12) << "worst us"
+        << std::setw(9) << "hits" << std::setw(10) << "speedup" << std::endl;
+
+    const int grids[] = { 100, 316, 1000, 2000 };   // 2 * g^2 triangles
+    Random random(RANDOM_SEED, 7);
+    for (int g : grids)
+    {
+        // bumpy unit sphere, latitude x longitude
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        positions.reserve((size_t)(g + 1) * (g + 1));
+        for (int i = 0; i <= g; i++)
+        {
+            for (int j = 0; j <= g; j++)
+            {
+                const float th = 3.1415926f * i / g, ph = 2.0f * 3.1415926f * j / g;
+                const float r = 1.0f + 0.05f * std::sin(th * 23.0f) * std::sin(ph * 17.0f);
+                positions.push_back(r * glm::vec3(std::sin(th) * std::cos(ph), std::cos(th), std::sin(th) * std::sin(ph)));
+            }
+        }
+        for (int i = 0; i < g; i++)
+        {
+            for (int j = 0; j < g; j++)
+            {
+                const uint32_t a = i * (g + 1) + j, b = a + 1, c = a + g + 1, d = c + 1;
+                indices.insert(indices.end(), { a, c, b, b, c, d });
+            }
+        }
+
+        TriangleBVH mesh;
+        auto b0 = std::chrono::steady_clock::now();
+        mesh.build(positions.data(), indices.data(), indices.size() / 3);
+        auto b1 = std::chrono::steady_clock::now();
+        const double buildMs = std::chrono::duration<double, std::milli>(b1 - b0).count();
+
+        for (int side : { 1, 4 })
+        {
+            RayScene scene;
+            for (int x = 0; x < side; x++)
+                for (int y = 0; y < side; y++)
+                    for (int z = 0; z < side; z++)
+                        scene.add(mesh, glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z) * 2.5f));
+            const glm::vec3 center = glm::vec3(side - 1) * 1.25f;
+            const float reach = side * 2.5f;
+
+            // from a sphere around everything towards random points inside it
+            const int rays = 20000;
+            std::vector<glm::vec3> from(rays), dir(rays);
+            for (int r = 0; r < rays; r++)
+            {
+                glm::vec3 f(random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f));
+                glm::vec3 to(random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f), random.uniform(-1.0f, 1.0f));
+                from[r] = center + glm::normalize(f + glm::vec3(1e-6f)) * reach * 1.5f;
+                dir[r] = glm::normalize(center + to * reach * 0.5f - from[r]);
+            }
+
+            // us/ray: wall time over all rays, so it drops with the thread count
+            double single = 0.0;
+            forEachThreadCount([&](unsigned int threads, ThreadPool* pool) {
+                const size_t grain = 256;
+                std::vector<int> hits((rays + grain - 1) / grain, 0);
+                std::vector<double> worst(hits.size(), 0.0);
+                auto castRange = [&](size_t begin, size_t end) {
+                    for (size_t r = begin; r < end; r++)
+                    {
+                        auto t0 = std::chrono::steady_clock::now();
+                        RayHit hit = scene.cast(from[r], dir[r]);
+                        auto t1 = std::chrono::steady_clock::now();
+                        worst[begin / grain] = std::max(worst[begin / grain], std::chrono::duration<double, std::micro>(t1 - t0).count());
+                        hits[begin / grain] += hit.hit();
+                    }
+                };
+
+                auto t0 = std::chrono::steady_clock::now();
+                if (pool) pool->parallelFor(rays, grain, castRange);
+                else      castRange(0, rays);
+                auto t1 = std::chrono::steady_clock::now();
+
+                const double perRay = std::chrono::duration<double, std::micro>(t1 - t0).count() / rays;
+                if (threads == 1) single = perRay;
+                std::cout << std::setw(12) << mesh.triangleCount() << std::setw(11) << scene.size()
+                    << std::setw(12) << std::fixed << std::setprecision(1) << buildMs << std::setw(9) << threads
+                    << std::setw(12) << std::setprecision(2) << perRay
+                    << std::setw(12) << std::setprecision(1) << *std::max_element(worst.begin(), worst.end())
+                    << std::setw(8) << std::setprecision(0) << 100.0 * std::accumulate(hits.begin(), hits.end(), 0) / rays << "%"
+                    << std::setw(9) << std::setprecision(2) << single / perRay << "x" << std::endl;
+            });
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+#version 330 core
+// seven-segment readout evaluated per pixel: every segment is a box distance field,
+// so a number of any shown length is a single quad
+out vec4 FragColor;
+
+in vec2 vLocal;
+
+uniform vec2 uSize;
+// bits 0-6: ones digit (segments a-g), 7-13: tens digit, 14: minus sign, 15: tens digit shown
+uniform int uSegments;
+uniform vec3 uOnColor;
+uniform vec3 uOffColor;
+
+float boxDistance(vec2 p, vec2 center, vec2 halfSize)
+{
+    vec2 q = abs(p - center) - halfSize;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);
+}
+
+// closest segment of the digit centered at 'origin': x = distance, y = its bit
+vec2 digit(vec2 p, vec2 origin)
+{
+    float w = uSize.x * 0.40;
+    float h = uSize.y * 0.75;
+    float t = uSize.y * 0.10;
+
+    vec2 horiz = vec2(w, t) * 0.5;
+    vec2 vert = vec2(t, h * 0.5) * 0.5;
+
+    // a, b, c, d, e, f, g
+    float d[7];
+    d[0] = boxDistance(p, origin + vec2(0.0, h * 0.5), horiz);
+    d[1] = boxDistance(p, origin + vec2(w * 0.5, h * 0.25), vert);
+    d[2] = boxDistance(p, origin + vec2(w * 0.5, -h * 0.25), vert);
+    d[3] = boxDistance(p, origin + vec2(0.0, -h * 0.5), horiz);
+    d[4] = boxDistance(p, origin + vec2(-w * 0.5, -h * 0.25), vert);
+    d[5] = boxDistance(p, origin + vec2(-w * 0.5, h * 0.25), vert);
+    d[6] = boxDistance(p, origin, horiz);
+
+    vec2 best = vec2(d[0], 0.0);
+    for (int i = 1; i < 7; i++)
+        if (d[i] < best.x) best = vec2(d[i], float(i));
+    return best;
+}
+
+void main()
+{
+    bool twoDigits = (uSegments & (1 << 15)) != 0;
+    float dx = twoDigits ? uSize.x * 0.24 : 0.0;
+
+    // ones digit, then the tens digit if shown
+    vec2 ones = digit(vLocal, vec2(dx, 0.0));
+    bool lit = ones.x <= 0.0 && (uSegments & (1 << int(ones.y))) != 0;
+    bool inside = ones.x <= 0.0;
+
+    if (twoDigits)
+    {
+        vec2 tens = digit(vLocal, vec2(-dx, 0.0));
+        if (tens.x <= 0.0)
+        {
+            inside = true;
+            lit = (uSegments & (1 << (7 + int(tens.y)))) != 0;
+        }
+    }
+
+    // minus sign left of the digits
+    if ((uSegments & (1 << 14)) != 0)
+    {
+        float minusX = -uSize.x * 0.24 * 1.70;
+        if (boxDistance(vLocal, vec2(minusX, 0.0), vec2(uSize.x * 0.06, uSize.y * 0.035)) <= 0.0)
+        {
+            inside = true;
+            lit = true;
+        }
+    }
+
+    if (!inside) discard;
+    FragColor = vec4(lit ? uOnColor : uOffColor, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+// one quad per seven-segment readout (see segment.frag)
+layout (location = 0) in vec2 inPos;
+layout (location = 1) in vec2 inUV;
+
+out vec2 vLocal;
+
+layout (std140) uniform FrameData
+{
+    mat4 uP;
+    mat4 uV;
+    mat4 uVP;
+    vec3 uLightPos;
+    vec3 uViewPos;
+    vec3 uLightColor;
+};
+
+uniform mat4 uM;     // places the unit quad over the screen (translate + scale to uSize)
+uniform vec2 uSize;  // screen width/height in world units
+
+void main()
+{
+    vLocal = inPos * uSize;   // world units from the screen center
+    gl_Position = uVP * (uM * vec4(inPos, 0.0, 1.0));
+}
@@ -4,71 +4,101 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include "program_cache.hpp"
+#include "shader_sources.hpp"
+
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
 #include <iostream>
 
+// FNV-1a hash of a uniform name; constexpr so literal names hash at compile time
+constexpr uint32_t uniformHash(std::string_view name)
+{
+    uint32_t h = 2166136261u;
+    for (char c : name)
+    {
+        h ^= (uint8_t)c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// uniform name, reduced to its hash. built implicitly from literals / strings; a literal only
+// hashes at compile time when the key is a constexpr constant: constexpr UniformKey U_X("uX");
+struct UniformKey {
+    uint32_t hash;
+    constexpr UniformKey(const char* name) : hash(uniformHash(name)) {}
+    constexpr UniformKey(std::string_view name) : hash(uniformHash(name)) {}
+    UniformKey(const std::string& name) : hash(uniformHash(name)) {}
+};
+
+// cached handle returned by Shader::uniform()
+struct Uniform {
+    int slot = -1;
+};
+
 class Shader
 {
 public:
-    unsigned int ID;
-    // constructor generates the shader on the fly
+    unsigned int ID = 0;
+    std::string vertexFile;     // shader names, see ShaderSources
+    std::string fragmentFile;
+    std::string defines;    // "#define X\n" lines inserted after #version (see ShaderVariants)
+    std::vector<std::string> feedbackVaryings;  // captured interleaved by transform feedback
+    // constructor generates the shader on the fly.
+    // 'deferred' only queues the compile + link (see ShaderBatch); the program is usable
+    // once finishCompile() has run.
+    // 'feedback' names vertex outputs to capture with transform feedback (set before linking)
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defineLines = "", bool deferred = false,
+        std::vector<std::string> feedback = {})
     {
-        // 1. retrieve the vertex/fragment source code from filePath
+        // 1. retrieve the vertex/fragment source code (embedded, or from disk when developing)
+        vertexFile = vertexPath;
+        fragmentFile = fragmentPath;
+        defines = defineLines;
+        feedbackVaryings = std::move(feedback);
         std::string vertexCode;
         std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
+        uint64_t cacheKey = 0;
+        if (!readSources(vertexCode, fragmentCode, cacheKey))
         {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            std::cout << "ERROR::SHADER::SOURCES_NOT_READ: " << vertexFile << " + " << fragmentFile << std::endl;
+            return;
         }
-        catch (std::ifstream::failure& e)
+        // 2. reuse the linked binary of a previous run when the driver still accepts it
+        ID = glCreateProgram();
+        if (ProgramCache::load(ID, cacheKey))
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+            reflectUniforms();
+            return;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-
+        glDeleteProgram(ID);
+        ID = 0;
+        // 3. compile shaders and link them
+        submitCompile(vertexCode, fragmentCode, cacheKey);
+        if (!deferred)
+            finishCompile();
+    }
+    // false when there is no program and none on the way (sources missing, compile or link failed);
+    // draws with such a shader silently do nothing
+    bool valid() const
+    {
+        return ID != 0 || pending.program != 0;
+    }
+    // inserts define lines right after the #version directive (which has to stay first)
+    // ------------------------------------------------------------------------
+    static void injectDefines(std::string& code, const std::string& defineLines)
+    {
+        if (defineLines.empty()) return;
+        size_t version = code.find("#version");
+        size_t at = (version == std::string::npos) ? 0 : code.find('\n', version);
+        at = (at == std::string::npos) ? code.size() : at + 1;
+        code.insert(at, defineLines);
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -76,66 +106,434 @@ public:
     {
         glUseProgram(ID);
     }
+    // uniform handles
+    // ------------------------------------------------------------------------
+    // returns a handle that stays valid for the lifetime of the Shader; cache it
+    // at the call site and the setters below become a plain array read + glUniform*
+    Uniform uniform(UniformKey key)
+    {
+        if ((tableUsed + 1) * 2 > table.size()) rehash(std::max<size_t>(16, table.size() * 2));
+        UniformEntry& e = insert(key.hash);
+        if (e.slot < 0)
+        {
+            e.slot = (int)slots.size();
+            slots.push_back({ key.hash, e.location });
+        }
+        return Uniform{ e.slot };
+    }
+    // location of an active uniform, -1 if the program doesn't use it (no GL call)
+    GLint location(UniformKey key) const
+    {
+        return findLocation(key.hash);
+    }
+    GLint location(Uniform u) const
+    {
+        return (u.slot >= 0 && u.slot < (int)slots.size()) ? slots[u.slot].location : -1;
+    }
     // utility uniform functions
+    // accept either a cached Uniform handle or a name / hashed key (no allocation)
+    // ------------------------------------------------------------------------
+    void setBool(UniformKey key, bool value) const
+    {
+        glUniform1i(location(key), (int)value);
+    }
+    void setBool(Uniform u, bool value) const
+    {
+        glUniform1i(location(u), (int)value);
+    }
     // ------------------------------------------------------------------------
-    void setBool(const std::string& name, bool value) const
+    void setInt(UniformKey key, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(location(key), value);
+    }
+    void setInt(Uniform u, int value) const
+    {
+        glUniform1i(location(u), value);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string& name, int value) const
+    void setFloat(UniformKey key, float value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(location(key), value);
+    }
+    void setFloat(Uniform u, float value) const
+    {
+        glUniform1f(location(u), value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string& name, float value) const
+    void setVec2(UniformKey key, const glm::vec2& value) const
+    {
+        glUniform2fv(location(key), 1, &value[0]);
+    }
+    void setVec2(Uniform u, const glm::vec2& value) const
+    {
+        glUniform2fv(location(u), 1, &value[0]);
+    }
+    void setVec2(UniformKey key, float x, float y) const
+    {
+        glUniform2f(location(key), x, y);
+    }
+    void setVec2(Uniform u, float x, float y) const
+    {
+        glUniform2f(location(u), x, y);
+    }
+    // ------------------------------------------------------------------------
+    void setVec3(UniformKey key, const glm::vec3& value) const
+    {
+        glUniform3fv(location(key), 1, &value[0]);
+    }
+    void setVec3(Uniform u, const glm::vec3& value) const
+    {
+        glUniform3fv(location(u), 1, &value[0]);
+    }
+    void setVec3(UniformKey key, float x, float y, float z) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform3f(location(key), x, y, z);
+    }
+    void setVec3(Uniform u, float x, float y, float z) const
+    {
+        glUniform3f(location(u), x, y, z);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string& name, const glm::vec2& value) const
+    void setVec4(UniformKey key, const glm::vec4& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4fv(location(key), 1, &value[0]);
     }
-    void setVec2(const std::string& name, float x, float y) const
+    void setVec4(Uniform u, const glm::vec4& value) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform4fv(location(u), 1, &value[0]);
+    }
+    void setVec4(UniformKey key, float x, float y, float z, float w) const
+    {
+        glUniform4f(location(key), x, y, z, w);
+    }
+    void setVec4(Uniform u, float x, float y, float z, float w) const
+    {
+        glUniform4f(location(u), x, y, z, w);
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string& name, const glm::vec3& value) const
+    void setMat2(UniformKey key, const glm::mat2& mat) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniformMatrix2fv(location(key), 1, GL_FALSE, &mat[0][0]);
     }
-    void setVec3(const std::string& name, float x, float y, float z) const
+    void setMat2(Uniform u, const glm::mat2& mat) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniformMatrix2fv(location(u), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string& name, const glm::vec4& value) const
+    void setMat3(UniformKey key, const glm::mat3& mat) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniformMatrix3fv(location(key), 1, GL_FALSE, &mat[0][0]);
     }
-    void setVec4(const std::string& name, float x, float y, float z, float w) const
+    void setMat3(Uniform u, const glm::mat3& mat) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniformMatrix3fv(location(u), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string& name, const glm::mat2& mat) const
+    void setMat4(UniformKey key, const glm::mat4& mat) const
+    {
+        glUniformMatrix4fv(location(key), 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(Uniform u, const glm::mat4& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(u), 1, GL_FALSE, &mat[0][0]);
     }
+    // uniform blocks
     // ------------------------------------------------------------------------
-    void setMat3(const std::string& name, const glm::mat3& mat) const
+    // both bindings are program state, so they are remembered and re-applied whenever
+    // a new program is swapped in (deferred compile, hot reload)
+    void bindUniformBlock(const std::string& name, unsigned int binding)
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        blockBindings.push_back({ name, binding });
+        if (ID) applyBlockBinding(name, binding);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string& name, const glm::mat4& mat) const
+    void bindSampler(const std::string& name, int unit)
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        samplerBindings.push_back({ name, unit });
+        if (!ID) return; // still compiling, applied by finishCompile()
+        use();
+        setInt(name, unit);
+    }
+    // asynchronous compile
+    // ------------------------------------------------------------------------
+    // queues compile + link of both stages into a new program without asking for any
+    // status: with KHR_parallel_shader_compile the driver works on its own threads
+    void submitCompile(const std::string& vertexCode, const std::string& fragmentCode, uint64_t cacheKey)
+    {
+        discardPending();
+
+        const char* vShaderCode = vertexCode.c_str();
+        const char* fShaderCode = fragmentCode.c_str();
+
+        pending.vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(pending.vertex, 1, &vShaderCode, NULL);
+        glCompileShader(pending.vertex);
+        pending.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(pending.fragment, 1, &fShaderCode, NULL);
+        glCompileShader(pending.fragment);
+
+        pending.program = glCreateProgram();
+        ProgramCache::prepare(pending.program);
+        glAttachShader(pending.program, pending.vertex);
+        glAttachShader(pending.program, pending.fragment);
+        if (!feedbackVaryings.empty())
+        {
+            std::vector<const char*> names;
+            for (const std::string& v : feedbackVaryings) names.push_back(v.c_str());
+            glTransformFeedbackVaryings(pending.program, (GLsizei)names.size(), names.data(), GL_INTERLEAVED_ATTRIBS);
+        }
+        glLinkProgram(pending.program);
+        // signals once the driver has worked through the compile + link commands above;
+        // the only non-blocking progress signal there is without the extension
+        pending.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        pending.cacheKey = cacheKey;
+    }
+    // KHR_parallel_shader_compile (or its ARB twin): GL_COMPLETION_STATUS can be polled
+    static bool parallelCompileSupported()
+    {
+        return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+    }
+    // ------------------------------------------------------------------------
+    bool compilePending() const
+    {
+        return pending.program != 0;
+    }
+    // true when finishCompile() won't block. without the extension it falls back to the
+    // fence placed after the link: a driver that links lazily on the status query can
+    // still stall there, pollReload() reports it
+    bool compileDone() const
+    {
+        if (!pending.program) return true;
+        if (!parallelCompileSupported())
+            return glClientWaitSync(pending.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED;
+        GLint done = GL_FALSE;
+        glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+    // checks the queued program (waits for the driver if it isn't done) and swaps it in
+    // on success. on failure the log is printed and the current program stays.
+    bool finishCompile()
+    {
+        if (!pending.program) return false;
+
+        GLint success = 0;
+        glGetProgramiv(pending.program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            checkCompileErrors(pending.vertex, "VERTEX");
+            checkCompileErrors(pending.fragment, "FRAGMENT");
+            checkCompileErrors(pending.program, "PROGRAM");
+            discardPending();
+            return false;
+        }
+
+        // delete the shaders as they're linked into our program now and no longer necessary
+        glDeleteShader(pending.vertex);
+        glDeleteShader(pending.fragment);
+        glDeleteSync(pending.fence);
+        glDeleteProgram(ID);
+        ID = pending.program;
+        ProgramCache::store(ID, pending.cacheKey);
+        pending = PendingProgram();
+
+        // cached Uniform handles are re-resolved, program state is re-applied
+        reflectUniforms();
+        for (const BlockBinding& b : blockBindings)
+            applyBlockBinding(b.name, b.binding);
+        if (!samplerBindings.empty())
+        {
+            use();
+            for (const SamplerBinding& b : samplerBindings)
+                setInt(b.name, b.unit);
+        }
+        return true;
+    }
+    // hot reload
+    // ------------------------------------------------------------------------
+    // re-reads the source files and starts compiling them into a new program.
+    // the current program keeps rendering until the new one has linked successfully.
+    void beginReload()
+    {
+        std::string vertexCode, fragmentCode;
+        uint64_t cacheKey = 0;
+        if (!readSources(vertexCode, fragmentCode, cacheKey)) return; // editor may still be writing, wait for the next event
+        submitCompile(vertexCode, fragmentCode, cacheKey);
+    }
+    // call once per frame (outside of any draw); returns true when a new program was swapped in
+    bool pollReload()
+    {
+        if (!pending.program || !compileDone()) return false;
+
+        auto start = std::chrono::steady_clock::now();
+        bool linked = finishCompile();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        // with only the fence to go by, the link status query may still have waited on the driver
+        if (ms > 1.0)
+            std::cout << "SHADER RELOAD STALLED the frame for " << ms << " ms: " << vertexFile << " + " << fragmentFile << std::endl;
+
+        if (!linked)
+        {
+            std::cout << "SHADER RELOAD FAILED: " << vertexFile << " + " << fragmentFile << ", keeping the old program" << std::endl;
+            return false;
+        }
+        std::cout << "SHADER RELOADED: " << vertexFile << " + " << fragmentFile << std::endl;
+        return true;
     }
 
 private:
+    struct BlockBinding {
+        std::string name;
+        unsigned int binding;
+    };
+    struct SamplerBinding {
+        std::string name;
+        int unit;
+    };
+    struct PendingProgram {
+        GLuint program = 0;
+        GLuint vertex = 0;
+        GLuint fragment = 0;
+        uint64_t cacheKey = 0;
+        GLsync fence = nullptr;   // placed after the link, see compileDone()
+    };
+    std::vector<BlockBinding> blockBindings;
+    std::vector<SamplerBinding> samplerBindings;
+    PendingProgram pending;
+
+    void applyBlockBinding(const std::string& name, unsigned int binding) const
+    {
+        unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
+
+    void discardPending()
+    {
+        if (!pending.program) return;
+        glDeleteShader(pending.vertex);
+        glDeleteShader(pending.fragment);
+        glDeleteSync(pending.fence);
+        glDeleteProgram(pending.program);
+        pending = PendingProgram();
+    }
+
+    // final sources (defines injected) and the program cache key
+    bool readSources(std::string& vertexCode, std::string& fragmentCode, uint64_t& cacheKey) const
+    {
+        ShaderSource vs = ShaderSources::load(vertexFile);
+        ShaderSource fs = ShaderSources::load(fragmentFile);
+        if (!vs.ok || !fs.ok) return false;
+
+        vertexCode = std::move(vs.text);
+        fragmentCode = std::move(fs.text);
+        injectDefines(vertexCode, defines);
+        injectDefines(fragmentCode, defines);
+        // captured varyings are part of the linked program, so part of the key too
+        std::string linkState = defines;
+        for (const std::string& v : feedbackVaryings) linkState += "feedback " + v + "\n";
+        cacheKey = ProgramCache::key(vs.hash, fs.hash, linkState);
+        return true;
+    }
+
+    struct UniformEntry {
+        uint32_t hash = 0;
+        GLint location = -1;   // -1: not an active uniform, only asked for through uniform()
+        int slot = -1;         // handle given out by uniform(), -1 if none yet
+        bool used = false;
+    };
+    struct UniformSlot {
+        uint32_t hash;
+        GLint location;
+    };
+    // open-addressing table (power of two, at most half full) of every active uniform,
+    // filled once after linking, plus every name uniform() was asked for
+    std::vector<UniformEntry> table;
+    size_t tableUsed = 0;
+    // handles given out by uniform(), re-resolved whenever the table is rebuilt
+    std::vector<UniformSlot> slots;
+
+    // bucket holding 'hash', or the empty one it would go into (table not empty)
+    size_t probe(uint32_t hash) const
+    {
+        size_t mask = table.size() - 1;
+        size_t i = hash & mask;
+        while (table[i].used && table[i].hash != hash) i = (i + 1) & mask;
+        return i;
+    }
+
+    // caller makes sure there is room
+    UniformEntry& insert(uint32_t hash)
+    {
+        UniformEntry& e = table[probe(hash)];
+        if (!e.used)
+        {
+            e.used = true;
+            e.hash = hash;
+            tableUsed++;
+        }
+        return e;
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<UniformEntry> old = std::move(table);
+        table.assign(capacity, UniformEntry());
+        tableUsed = 0;
+        for (const UniformEntry& e : old)
+            if (e.used) insert(e.hash) = e;
+    }
+
+    GLint findLocation(uint32_t hash) const
+    {
+        if (table.empty()) return -1;
+        return table[probe(hash)].location;   // an empty bucket says -1 too
+    }
+
+    // enumerates the program's active uniforms (GL_ACTIVE_UNIFORMS) into the table
+    void reflectUniforms()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        size_t capacity = 16;
+        while (capacity < ((size_t)count + slots.size()) * 2) capacity *= 2;
+        table.assign(capacity, UniformEntry());
+        tableUsed = 0;
+
+        std::vector<GLchar> name(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+            // members of uniform blocks have no location
+            GLint loc = glGetUniformLocation(ID, name.data());
+            if (loc < 0) continue;
+
+            // arrays are reported as "name[0]"; store them under "name"
+            std::string_view n(name.data(), (size_t)length);
+            if (n.size() > 3 && n.substr(n.size() - 3) == "[0]")
+                n = n.substr(0, n.size() - 3);
+
+            UniformEntry& e = insert(uniformHash(n));
+            if (e.location >= 0)
+                std::cout << "ERROR::SHADER::UNIFORM_HASH_COLLISION: " << n << std::endl;
+            e.location = loc;
+        }
+
+        // handles keep their slot, whether or not the new program uses the name
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            UniformEntry& e = insert(slots[i].hash);
+            e.slot = (int)i;
+            slots[i].location = e.location;
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
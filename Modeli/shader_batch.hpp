@@ -0,0 +1,117 @@
+#ifndef SHADER_BATCH_H
+#define SHADER_BATCH_H
+
+#include "shader.hpp"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+
+// Startup compilation of many programs at once.
+// every program is constructed 'deferred' (all stages + links are queued before anything
+// is queried), then finish() collects them in completion order, so the driver is free to
+// compile them in parallel instead of being forced to sync after each stage.
+class ShaderBatch {
+public:
+    ShaderBatch()
+    {
+        start = Clock::now();
+    }
+
+    // the shader must have been constructed with deferred = true (cache hits are fine too)
+    void add(Shader& shader)
+    {
+        Entry e;
+        e.shader = &shader;
+        e.name = shader.vertexFile + " + " + shader.fragmentFile;
+        if (!shader.defines.empty()) e.name += " [" + flatten(shader.defines) + "]";
+        e.submitted = Clock::now();
+        e.ok = shader.valid();   // sources missing: nothing queued, reported as FAILED
+        e.cached = e.ok && !shader.compilePending();
+        e.done = !shader.compilePending();
+        e.ms = 0.0;
+        entries.push_back(e);
+    }
+
+    // waits for every queued program; polls GL_COMPLETION_STATUS_KHR when available
+    void finish()
+    {
+        size_t remaining = 0;
+        for (const Entry& e : entries)
+            if (!e.done) remaining++;
+
+        while (remaining > 0)
+        {
+            bool progressed = false;
+            for (Entry& e : entries)
+            {
+                if (e.done || !e.shader->compileDone()) continue;
+
+                e.ok = e.shader->finishCompile();
+                e.ms = msSince(e.submitted);
+                e.done = true;
+                remaining--;
+                progressed = true;
+            }
+            if (!progressed)
+                std::this_thread::yield();
+        }
+
+        report();
+        entries.clear();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        Shader* shader;
+        std::string name;
+        Clock::time_point submitted;
+        double ms;
+        bool cached;
+        bool done;
+        bool ok = true;
+    };
+    std::vector<Entry> entries;
+    Clock::time_point start;
+
+    static double msSince(Clock::time_point t)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+    }
+
+    static std::string flatten(const std::string& defines)
+    {
+        std::string out;
+        size_t pos = 0;
+        while ((pos = defines.find("#define ", pos)) != std::string::npos)
+        {
+            pos += 8;
+            size_t end = defines.find('\n', pos);
+            if (!out.empty()) out += ' ';
+            out += defines.substr(pos, end - pos);
+        }
+        return out;
+    }
+
+    void report() const
+    {
+        std::cout << "SHADERS: " << entries.size() << " programs in " << std::fixed << std::setprecision(1)
+            << msSince(start) << " ms" << (Shader::parallelCompileSupported() ? " (parallel compile)" : "") << "\n";
+        for (const Entry& e : entries)
+        {
+            std::cout << "  " << std::setw(7) << e.ms << " ms  " << e.name;
+            if (e.cached) std::cout << "  (binary cache)";
+            if (!e.ok) std::cout << "  FAILED";
+            std::cout << "\n";
+        }
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::flush;
+    }
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SHADER_SOURCES_H
+#define SHADER_SOURCES_H
+
+#include "program_cache.hpp"
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+// define to always read the .vert/.frag files from the working directory (and hot reload them)
+// #define SHADER_SOURCES_FROM_DISK
+
+// environment variable naming a directory to read shader files from instead of the embedded copies
+#define SHADER_DIR_ENV "MODELI_SHADER_DIR"
+
+struct EmbeddedShader {
+    std::string_view name;
+    std::string_view source;
+    uint64_t hash;          // sourceHash(source), computed by the compiler
+};
+
+#include "shaders_embedded.hpp"
+
+struct ShaderSource {
+    std::string text;
+    uint64_t hash = 0;
+    bool ok = false;
+};
+
+// Where shader text comes from.
+// by default the sources compiled into the executable (shaders_embedded.hpp, generated by
+// tools/embed_shaders.py before every build), so startup needs no files and no cwd.
+// for development either SHADER_SOURCES_FROM_DISK or MODELI_SHADER_DIR=<dir> switches to the
+// files on disk, which is also what enables hot reload.
+class ShaderSources {
+public:
+    static bool fromDisk()
+    {
+        return !directory().empty();
+    }
+
+    // path a shader is read from in disk mode
+    static std::string path(const std::string& name)
+    {
+        const std::string& dir = directory();
+        if (dir.empty() || dir == ".") return name;
+        char last = dir.back();
+        return (last == '/' || last == '\\') ? dir + name : dir + "/" + name;
+    }
+
+    static ShaderSource load(const std::string& name)
+    {
+        ShaderSource s;
+        if (!fromDisk())
+        {
+            for (const EmbeddedShader& e : EMBEDDED_SHADERS)
+            {
+                if (e.name != name) continue;
+                s.text.assign(e.source.data(), e.source.size());
+                s.hash = e.hash;
+                s.ok = true;
+                return s;
+            }
+            std::cout << "ERROR::SHADER::NOT_EMBEDDED: " << name << " (rerun tools/embed_shaders.py), trying the file" << std::endl;
+        }
+
+        std::ifstream file(path(name));
+        if (!file)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path(name) << std::endl;
+            return s;
+        }
+        std::stringstream ss;
+        ss << file.rdbuf();
+        s.text = ss.str();
+        s.hash = sourceHash(s.text);
+        s.ok = true;
+        return s;
+    }
+
+private:
+    // empty: embedded sources
+    static const std::string& directory()
+    {
+        static const std::string dir = [] {
+            const char* env = std::getenv(SHADER_DIR_ENV);
+            if (env && *env) return std::string(env);
+#ifdef SHADER_SOURCES_FROM_DISK
+            return std::string(".");
+#else
+            return std::string();
+#endif
+        }();
+        return dir;
+    }
+};
+
+#endif
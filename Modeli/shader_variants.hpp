@@ -0,0 +1,339 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "shader.hpp"
+#include "shader_batch.hpp"
+#include "program_cache.hpp"
+#include "shader_sources.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <cctype>
+
+// Permutations of one vertex/fragment pair, specialized with #defines from feature bits.
+// bit i of a feature mask turns into "#define <featureNames[i]>".
+//  - bits whose name no #ifdef / #ifndef / #if / #elif tests are dropped, so they don't multiply variants
+//  - variants are deduplicated by their sources with the feature conditionals resolved: masks
+//    that leave the same code behind (a define whose only use sits in a dead branch) share a program
+//  - get() compiles a missing variant on first use, precompile() does it up front from a manifest
+class ShaderVariants {
+public:
+    // called once for every newly compiled variant (uniform blocks, samplers, hot reload, ...)
+    std::function<void(Shader&)> onCreate;
+
+    // OR-ed into every mask get() is asked for: a whole pass drawn in another mode (e.g. PICK)
+    // without touching the code that picks the variants
+    uint32_t passFeatures = 0;
+
+    ShaderVariants(const char* vertexPath, const char* fragmentPath, std::vector<std::string> featureNames)
+        : vertexFile(vertexPath), fragmentFile(fragmentPath), features(std::move(featureNames))
+    {
+        vertexText = ShaderSources::load(vertexFile).text;
+        fragmentText = ShaderSources::load(fragmentFile).text;
+        relevant = testedFeatures(vertexText) | testedFeatures(fragmentText);
+    }
+
+    void precompile(const uint32_t* manifest, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            get(manifest[i]);
+    }
+    // same, but only queues the work; 'batch.finish()' collects it
+    void precompile(const uint32_t* manifest, size_t count, ShaderBatch& batch)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t before = variants.size();
+            Shader& s = variant(manifest[i], true);
+            if (variants.size() != before) batch.add(s);
+        }
+    }
+
+    // cheapest program that implements 'featureMask'
+    Shader& get(uint32_t featureMask)
+    {
+        return variant(featureMask | passFeatures, false);
+    }
+
+    size_t size() const
+    {
+        return variants.size();
+    }
+
+    // every variant compiled so far is usable (see Shader::valid)
+    bool valid() const
+    {
+        for (const std::unique_ptr<Shader>& v : variants)
+            if (!v->valid()) return false;
+        return true;
+    }
+
+private:
+    std::string vertexFile;
+    std::string fragmentFile;
+    std::vector<std::string> features;
+    uint32_t relevant = 0;
+    std::string vertexText;     // as loaded at construction; hot reload edits don't redo the dedup
+    std::string fragmentText;
+
+    std::vector<std::unique_ptr<Shader>> variants;
+    std::unordered_map<uint32_t, size_t> byMask;
+    std::unordered_map<uint64_t, size_t> byHash;
+
+    Shader& variant(uint32_t featureMask, bool deferred)
+    {
+        featureMask &= relevant;
+
+        auto known = byMask.find(featureMask);
+        if (known != byMask.end()) return *variants[known->second];
+
+        // same code once the feature conditionals are resolved -> same program. a conditional
+        // left to the real preprocessor still sees the defines it names, so those go in too
+        std::string defines = defineLines(featureMask);
+        uint32_t unresolved = 0;
+        const std::string vs = specialize(vertexText, featureMask, unresolved);
+        const std::string fs = specialize(fragmentText, featureMask, unresolved);
+        uint64_t key = ProgramCache::key(sourceHash(vs), sourceHash(fs), defineLines(featureMask & unresolved));
+        auto same = byHash.find(key);
+        if (same != byHash.end())
+        {
+            byMask[featureMask] = same->second;
+            return *variants[same->second];
+        }
+
+        variants.push_back(std::make_unique<Shader>(vertexFile.c_str(), fragmentFile.c_str(), defines, deferred));
+        size_t index = variants.size() - 1;
+        byHash[key] = index;
+        byMask[featureMask] = index;
+
+        if (onCreate) onCreate(*variants[index]);
+        return *variants[index];
+    }
+
+    std::string defineLines(uint32_t featureMask) const
+    {
+        std::string d;
+        for (size_t i = 0; i < features.size() && i < 32; i++)
+            if (featureMask & (1u << i)) d += "#define " + features[i] + "\n";
+        return d;
+    }
+
+    // ----- just enough of the GLSL preprocessor to resolve the feature conditionals -----
+
+    // "#  ifdef NAME ..." -> word "ifdef", rest "NAME ..." (comment stripped); false if no directive
+    static bool directive(const std::string& line, std::string& word, std::string& rest)
+    {
+        size_t i = line.find_first_not_of(" \t");
+        if (i == std::string::npos || line[i] != '#') return false;
+        i = line.find_first_not_of(" \t", i + 1);
+        if (i == std::string::npos) i = line.size();
+        size_t w = i;
+        while (w < line.size() && std::isalpha((unsigned char)line[w])) w++;
+        word = line.substr(i, w - i);
+        rest = line.substr(w, line.find("//", w) == std::string::npos ? std::string::npos : line.find("//", w) - w);
+        return true;
+    }
+
+    static bool isConditional(const std::string& word)
+    {
+        return word == "if" || word == "ifdef" || word == "ifndef" || word == "elif";
+    }
+
+    // identifiers and the operators #if uses; anything else comes out as one odd token
+    static std::vector<std::string> tokens(const std::string& text)
+    {
+        std::vector<std::string> out;
+        size_t i = 0;
+        while (i < text.size())
+        {
+            const char c = text[i];
+            if (std::isspace((unsigned char)c)) { i++; continue; }
+            size_t j = i + 1;
+            if (std::isalnum((unsigned char)c) || c == '_')
+                while (j < text.size() && (std::isalnum((unsigned char)text[j]) || text[j] == '_')) j++;
+            else if ((c == '&' || c == '|') && j < text.size() && text[j] == c)
+                j++;
+            out.push_back(text.substr(i, j - i));
+            i = j;
+        }
+        return out;
+    }
+
+    int featureIndex(const std::string& name) const
+    {
+        for (size_t i = 0; i < features.size() && i < 32; i++)
+            if (features[i] == name) return (int)i;
+        return -1;
+    }
+
+    // bits of the features named in one directive's text
+    uint32_t namedFeatures(const std::string& rest) const
+    {
+        uint32_t mask = 0;
+        for (const std::string& t : tokens(rest))
+        {
+            const int f = featureIndex(t);
+            if (f >= 0) mask |= 1u << f;
+        }
+        return mask;
+    }
+
+    // bits of every feature some conditional directive of 'text' names
+    uint32_t testedFeatures(const std::string& text) const
+    {
+        uint32_t mask = 0;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t end = text.find('\n', pos);
+            if (end == std::string::npos) end = text.size();
+            std::string word, rest;
+            if (directive(text.substr(pos, end - pos), word, rest) && isConditional(word))
+                mask |= namedFeatures(rest);
+            pos = end + 1;
+        }
+        return mask;
+    }
+
+    // #if expression made of defined(FEATURE), !, &&, || and parentheses:
+    // 1 / 0, or -1 when it depends on anything else (then it is left to the real preprocessor)
+    int evaluate(const std::string& expression, uint32_t featureMask) const
+    {
+        const std::vector<std::string> t = tokens(expression);
+        size_t i = 0;
+        bool unknown = false;
+        std::function<bool()> orExpr, andExpr, unary;
+        unary = [&]() -> bool {
+            if (i >= t.size()) { unknown = true; return false; }
+            if (t[i] == "!") { i++; return !unary(); }
+            if (t[i] == "(") {
+                i++;
+                bool v = orExpr();
+                if (i < t.size() && t[i] == ")") i++; else unknown = true;
+                return v;
+            }
+            if (t[i] == "defined") {
+                i++;
+                const bool paren = i < t.size() && t[i] == "(";
+                if (paren) i++;
+                const int f = i < t.size() ? featureIndex(t[i]) : -1;
+                i++;
+                if (paren) { if (i < t.size() && t[i] == ")") i++; else unknown = true; }
+                if (f < 0) { unknown = true; return false; }
+                return (featureMask >> f) & 1u;
+            }
+            unknown = true;
+            i++;
+            return false;
+        };
+        andExpr = [&]() -> bool {
+            bool v = unary();
+            while (i < t.size() && t[i] == "&&") { i++; v = unary() && v; }
+            return v;
+        };
+        orExpr = [&]() -> bool {
+            bool v = andExpr();
+            while (i < t.size() && t[i] == "||") { i++; v = andExpr() || v; }
+            return v;
+        };
+        const bool v = orExpr();
+        if (unknown || i != t.size()) return -1;
+        return v ? 1 : 0;
+    }
+
+    // 'text' with every conditional on the features resolved for 'featureMask': the directives and
+    // the dead branches are gone. a chain that tests anything else is kept as written from there on;
+    // the features its kept directives name are added to 'unresolved'
+    std::string specialize(const std::string& text, uint32_t featureMask, uint32_t& unresolved) const
+    {
+        struct Level {
+            bool known;     // decided here; false = passed through to the real preprocessor
+            bool outer;     // the enclosing code is live
+            bool live;      // the current branch is live
+            bool taken;     // a branch of this chain was live already
+        };
+        std::vector<Level> stack;
+        std::string out;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t end = text.find('\n', pos);
+            if (end == std::string::npos) end = text.size();
+            const std::string line = text.substr(pos, end - pos);
+            pos = end + 1;
+
+            const bool outer = stack.empty() || stack.back().live;
+            std::string word, rest;
+            bool keep = outer;
+            if (directive(line, word, rest))
+            {
+                if (word == "if" || word == "ifdef" || word == "ifndef")
+                {
+                    int v;
+                    if (word == "if") v = evaluate(rest, featureMask);
+                    else
+                    {
+                        const std::vector<std::string> t = tokens(rest);
+                        const int f = t.empty() ? -1 : featureIndex(t[0]);
+                        v = f < 0 ? -1 : (int)(((featureMask >> f) & 1u) ^ (word == "ifndef" ? 1u : 0u));
+                    }
+                    stack.push_back({ v >= 0, outer, outer && v != 0, v == 1 });
+                    keep = outer && v < 0;
+                }
+                else if (word == "elif" && !stack.empty())
+                {
+                    Level& l = stack.back();
+                    if (!l.known) keep = l.outer;
+                    else
+                    {
+                        const int v = l.taken ? 0 : evaluate(rest, featureMask);
+                        if (v < 0)
+                        {
+                            // every earlier branch was dead: from here on it is an ordinary #if
+                            if (l.outer)
+                            {
+                                out += "#if" + rest + "\n";
+                                unresolved |= namedFeatures(rest);
+                            }
+                            l = { false, l.outer, l.outer, false };
+                            continue;
+                        }
+                        l.live = l.outer && v == 1;
+                        l.taken = l.taken || v == 1;
+                        keep = false;
+                    }
+                }
+                else if (word == "else" && !stack.empty())
+                {
+                    Level& l = stack.back();
+                    if (!l.known) keep = l.outer;
+                    else
+                    {
+                        l.live = l.outer && !l.taken;
+                        l.taken = true;
+                        keep = false;
+                    }
+                }
+                else if (word == "endif" && !stack.empty())
+                {
+                    keep = !stack.back().known && stack.back().outer;
+                    stack.pop_back();
+                }
+            }
+            if (keep)
+            {
+                if (directive(line, word, rest) && isConditional(word))
+                    unresolved |= namedFeatures(rest);
+                out += line;
+                out += '\n';
+            }
+        }
+        return out;
+    }
+};
+
+#endif
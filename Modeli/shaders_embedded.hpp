@@ -0,0 +1,613 @@
+// generated by tools/embed_shaders.py from the shader sources - do not edit
+#ifndef SHADERS_EMBEDDED_H
+#define SHADERS_EMBEDDED_H
+
+constexpr std::string_view BASIC_FRAG_SOURCE =
+    "#version 330 core\n"
+    "// features (see ShaderVariants): UNLIT, PICK\n"
+    "#ifdef PICK\n"
+    "out uint FragId;   // R32UI target of the ID pass (see pick_buffer.hpp)\n"
+    "flat in uint chPickId;\n"
+    "#else\n"
+    "out vec4 FragColor;\n"
+    "#endif\n"
+    "\n"
+    "in vec3 chNormal;  \n"
+    "in vec3 chFragPos;  \n"
+    "flat in vec3 chColor; // \366\342\345\362 \356\341\372\345\352\362\340\n"
+    "\n"
+    "layout (std140) uniform FrameData\n"
+    "{\n"
+    "    mat4 uP;\n"
+    "    mat4 uV;\n"
+    "    mat4 uVP;\n"
+    "    vec3 uLightPos;\n"
+    "    vec3 uViewPos;\n"
+    "    vec3 uLightColor;\n"
+    "};\n"
+    "\n"
+    "void main()\n"
+    "{    \n"
+    "#if defined(PICK)\n"
+    "    FragId = chPickId;\n"
+    "#elif defined(UNLIT)\n"
+    "    // flat emissive color (lamp), no lighting at all\n"
+    "    FragColor = vec4(chColor, 1.0);\n"
+    "#else\n"
+    "    // ambient\n"
+    "    float ambientStrength = 0.2;\n"
+    "    vec3 ambient = ambientStrength * uLightColor;\n"
+    "  \t\n"
+    "    // diffuse \n"
+    "    vec3 norm = normalize(chNormal);\n"
+    "    vec3 lightDir = normalize(uLightPos - chFragPos);\n"
+    "    float diff = max(dot(norm, lightDir), 0.0);\n"
+    "    vec3 diffuse = diff * uLightColor;\n"
+    "    \n"
+    "    // specular\n"
+    "    float specularStrength = 0.5;\n"
+    "    vec3 viewDir = normalize(uViewPos - chFragPos);\n"
+    "    vec3 reflectDir = reflect(-lightDir, norm);  \n"
+    "    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);\n"
+    "    vec3 specular = specularStrength * spec * uLightColor;  \n"
+    "\n"
+    "    vec3 result = (ambient + diffuse + specular) * chColor;\n"
+    "    FragColor = vec4(result, 1.0);\n"
+    "#endif\n"
+    "}";
+
+constexpr std::string_view BASIC_VERT_SOURCE =
+    "#version 330 core\n"
+    "// features (see ShaderVariants): UNLIT, INSTANCED, WATER, PARTICLE, PICK\n"
+    "layout (location = 0) in vec3 inPos;\n"
+    "layout (location = 1) in vec3 inNormal;\n"
+    "#ifdef INSTANCED\n"
+    "layout (location = 2) in int inObjectIndex;   // per instance (see cube_batch.hpp)\n"
+    "#endif\n"
+    "#ifdef PARTICLE\n"
+    "// per instance, one stream per axis (see particles.hpp)\n"
+    "layout (location = 3) in float inParticleX;\n"
+    "layout (location = 4) in float inParticleY;\n"
+    "layout (location = 5) in float inParticleZ;\n"
+    "layout (location = 6) in float inParticleVY;\n"
+    "uniform vec3 uParticleSize;\n"
+    "uniform float uParticleLag;   // seconds since the previous simulation tick still to cover\n"
+    "#endif\n"
+    "\n"
+    "out vec3 chFragPos;\n"
+    "out vec3 chNormal;\n"
+    "flat out vec3 chColor;\n"
+    "#ifdef PICK\n"
+    "flat out uint chPickId;   // ID pass (see pick_buffer.hpp)\n"
+    "#endif\n"
+    "\n"
+    "layout (std140) uniform FrameData\n"
+    "{\n"
+    "    mat4 uP;\n"
+    "    mat4 uV;\n"
+    "    mat4 uVP;\n"
+    "    vec3 uLightPos;\n"
+    "    vec3 uViewPos;\n"
+    "    vec3 uLightColor;\n"
+    "};\n"
+    "\n"
+    "// per-object records, OBJECT_TEXELS texels each (see object_buffer.hpp)\n"
+    "uniform samplerBuffer uObjects;\n"
+    "#ifndef INSTANCED\n"
+    "uniform int uObjectIndex;\n"
+    "#endif\n"
+    "\n"
+    "#ifdef WATER\n"
+    "// unit water body (see water.hpp): xz on the unit disc, y = 0 bottom ring / 1 surface\n"
+    "uniform vec4 uWaterShape;     // bottom radius, surface radius, bottom y, surface y\n"
+    "uniform sampler2D uRipples;   // ripple heightfield over the disc's bounding square\n"
+    "uniform float uRippleScale;   // heightfield unit -> world units\n"
+    "\n"
+    "// object-space position + normal of a unit-mesh vertex\n"
+    "void waterVertex(out vec3 pos, out vec3 normal)\n"
+    "{\n"
+    "    float r = mix(uWaterShape.x, uWaterShape.y, inPos.y);\n"
+    "    pos = vec3(inPos.x * r, mix(uWaterShape.z, uWaterShape.w, inPos.y), inPos.z * r);\n"
+    "    normal = inNormal;\n"
+    "    if (inPos.y < 0.5) return;\n"
+    "\n"
+    "    vec2 uv = inPos.xz * 0.5 + 0.5;\n"
+    "    pos.y += textureLod(uRipples, uv, 0.0).r * uRippleScale;\n"
+    "\n"
+    "    // surface normal from the heightfield slope (the rim of the side wall only moves)\n"
+    "    if (inNormal.y > 0.99)\n"
+    "    {\n"
+    "        float texel = 1.0 / float(textureSize(uRipples, 0).x);\n"
+    "        float hx = textureLod(uRipples, uv + vec2(texel, 0.0), 0.0).r - textureLod(uRipples, uv - vec2(texel, 0.0), 0.0).r;\n"
+    "        float hz = textureLod(uRipples, uv + vec2(0.0, texel), 0.0).r - textureLod(uRipples, uv - vec2(0.0, texel), 0.0).r;\n"
+    "        float span = 2.0 * texel * 2.0 * uWaterShape.y;   // world distance between the samples\n"
+    "        normal = normalize(vec3(-hx * uRippleScale / span, 1.0, -hz * uRippleScale / span));\n"
+    "    }\n"
+    "}\n"
+    "#endif\n"
+    "\n"
+    "mat4 objectModel(int i)\n"
+    "{\n"
+    "    int b = i * 8;\n"
+    "    return mat4(texelFetch(uObjects, b), texelFetch(uObjects, b + 1),\n"
+    "                texelFetch(uObjects, b + 2), texelFetch(uObjects, b + 3));\n"
+    "}\n"
+    "\n"
+    "// inverse-transpose of the model matrix, precomputed on the CPU\n"
+    "mat3 objectNormal(int i)\n"
+    "{\n"
+    "    int b = i * 8 + 4;\n"
+    "    return mat3(texelFetch(uObjects, b).xyz, texelFetch(uObjects, b + 1).xyz,\n"
+    "                texelFetch(uObjects, b + 2).xyz);\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "#ifdef INSTANCED\n"
+    "    int object = inObjectIndex;\n"
+    "#else\n"
+    "    int object = uObjectIndex;\n"
+    "#endif\n"
+    "    mat4 M = objectModel(object);\n"
+    "    chColor = texelFetch(uObjects, object * 8 + 7).rgb;\n"
+    "#ifdef PICK\n"
+    "    chPickId = uint(texelFetch(uObjects, object * 8 + 4).w);\n"
+    "#endif\n"
+    "\n"
+    "#ifdef WATER\n"
+    "    vec3 pos, normal;\n"
+    "    waterVertex(pos, normal);\n"
+    "#elif defined(PARTICLE)\n"
+    "    // the last tick moved the droplet by vy * dt: back up along it to the interpolated position\n"
+    "    vec3 pos = inPos * uParticleSize + vec3(inParticleX, inParticleY - inParticleVY * uParticleLag, inParticleZ);\n"
+    "    vec3 normal = inNormal / uParticleSize;\n"
+    "#else\n"
+    "    vec3 pos = inPos;\n"
+    "    vec3 normal = inNormal;\n"
+    "#endif\n"
+    "\n"
+    "    chFragPos = vec3(M * vec4(pos, 1.0));\n"
+    "#ifndef UNLIT\n"
+    "    chNormal = objectNormal(object) * normal;\n"
+    "#endif\n"
+    "    gl_Position = uVP * vec4(chFragPos, 1.0);\n"
+    "}\n";
+
+constexpr std::string_view BOUNDS_FRAG_SOURCE =
+    "#version 330 core\n"
+    "// color writes are masked off while the box is drawn; only the samples are counted\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    FragColor = vec4(1.0);\n"
+    "}";
+
+constexpr std::string_view BOUNDS_VERT_SOURCE =
+    "#version 330 core\n"
+    "// bounding box of an occlusion query (unit cube scaled by uM), depth only\n"
+    "layout (location = 0) in vec3 inPos;\n"
+    "\n"
+    "layout (std140) uniform FrameData\n"
+    "{\n"
+    "    mat4 uP;\n"
+    "    mat4 uV;\n"
+    "    mat4 uVP;\n"
+    "    vec3 uLightPos;\n"
+    "    vec3 uViewPos;\n"
+    "    vec3 uLightColor;\n"
+    "};\n"
+    "\n"
+    "uniform mat4 uM;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = uVP * (uM * vec4(inPos, 1.0));\n"
+    "}";
+
+constexpr std::string_view DROPLETS_FRAG_SOURCE =
+    "#version 330 core\n"
+    "// shared by the droplet update (rasterizer discard, never runs) and impact count passes\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    FragColor = vec4(1.0);\n"
+    "}\n";
+
+constexpr std::string_view DROPLETS_COUNT_VERT_SOURCE =
+    "#version 330 core\n"
+    "// impact counter: droplets that landed this step become a point on the single pixel of a\n"
+    "// 1x1 target, the rest are clipped; GL_SAMPLES_PASSED then is the number of impacts\n"
+    "layout (location = 0) in float inHit;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = inHit > 0.5 ? vec4(0.0, 0.0, 0.0, 1.0) : vec4(2.0, 2.0, 2.0, 1.0);\n"
+    "}\n";
+
+constexpr std::string_view DROPLETS_UPDATE_VERT_SOURCE =
+    "#version 330 core\n"
+    "// one droplet per vertex, written back with transform feedback (see gpu_droplets.hpp);\n"
+    "// same rules as DropletSystem in particles.hpp\n"
+    "layout (location = 0) in vec4 inState;   // x, y, z, vertical speed\n"
+    "layout (location = 1) in uint inSeed;\n"
+    "\n"
+    "out vec4 tfState;\n"
+    "flat out uint tfSeed;\n"
+    "out float tfHit;                         // 1 when it landed in the basin this step\n"
+    "\n"
+    "uniform vec3 uOrigin;      // outlet\n"
+    "uniform float uJitter;\n"
+    "uniform float uGravity;\n"
+    "uniform float uDt;\n"
+    "uniform vec4 uCapture;     // basin center x, center z, radius^2, water surface y\n"
+    "uniform float uKillY;\n"
+    "uniform bool uRespawnAll;\n"
+    "\n"
+    "// integer hash (lowbias32), the droplet's whole RNG; randomHash() / randomNext01() in random.hpp\n"
+    "uint hash(uint x)\n"
+    "{\n"
+    "    x ^= x >> 16u;\n"
+    "    x *= 0x7feb352du;\n"
+    "    x ^= x >> 15u;\n"
+    "    x *= 0x846ca68bu;\n"
+    "    x ^= x >> 16u;\n"
+    "    return x;\n"
+    "}\n"
+    "\n"
+    "float next01(inout uint seed)\n"
+    "{\n"
+    "    seed = hash(seed);\n"
+    "    return float(seed >> 8u) * (1.0 / 16777216.0);\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 s = inState;\n"
+    "    uint seed = inSeed;\n"
+    "\n"
+    "    s.w -= uGravity * uDt;\n"
+    "    s.y += s.w * uDt;\n"
+    "\n"
+    "    vec2 d = s.xz - uCapture.xy;\n"
+    "    bool captured = !uRespawnAll && s.y <= uCapture.w && dot(d, d) <= uCapture.z;\n"
+    "    if (captured || uRespawnAll || s.y < uKillY)\n"
+    "    {\n"
+    "        s.x = uOrigin.x + (next01(seed) * 2.0 - 1.0) * uJitter;\n"
+    "        s.y = uOrigin.y;\n"
+    "        s.z = uOrigin.z + (next01(seed) * 2.0 - 1.0) * uJitter;\n"
+    "        s.w = -0.2 - next01(seed) * 0.3;\n"
+    "    }\n"
+    "\n"
+    "    tfState = s;\n"
+    "    tfSeed = seed;\n"
+    "    tfHit = captured ? 1.0 : 0.0;\n"
+    "    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);   // rasterizer discard is on\n"
+    "}\n";
+
+constexpr std::string_view MODEL_FRAG_SOURCE =
+    "#version 330 core\n"
+    "// features (see ShaderVariants): DIFFUSE_MAP, SPEC_MAP, PICK\n"
+    "#ifdef PICK\n"
+    "out uint FragId;   // R32UI target of the ID pass (see pick_buffer.hpp)\n"
+    "flat in uint vPickId;\n"
+    "#else\n"
+    "out vec4 FragColor;\n"
+    "#endif\n"
+    "\n"
+    "in vec3 vNormal;\n"
+    "in vec3 vFragPos;\n"
+    "in vec2 vTex;\n"
+    "\n"
+    "layout (std140) uniform FrameData\n"
+    "{\n"
+    "    mat4 uP;\n"
+    "    mat4 uV;\n"
+    "    mat4 uVP;\n"
+    "    vec3 uLightPos;\n"
+    "    vec3 uViewPos;\n"
+    "    vec3 uLightColor;\n"
+    "};\n"
+    "\n"
+    "#ifdef DIFFUSE_MAP\n"
+    "uniform sampler2D uDiffMap1;\n"
+    "#endif\n"
+    "#ifdef SPEC_MAP\n"
+    "uniform sampler2D uSpecMap1;\n"
+    "#endif\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "#ifdef PICK\n"
+    "    FragId = vPickId;\n"
+    "#else\n"
+    "#ifdef DIFFUSE_MAP\n"
+    "    vec3 base = texture(uDiffMap1, vTex).rgb;\n"
+    "#else\n"
+    "    vec3 base = vec3(1.0);\n"
+    "#endif\n"
+    "\n"
+    "    // ambient\n"
+    "    float ambientStrength = 0.2;\n"
+    "    vec3 ambient = ambientStrength * uLightColor;\n"
+    "\n"
+    "    // diffuse\n"
+    "    vec3 norm = normalize(vNormal);\n"
+    "    vec3 lightDir = normalize(uLightPos - vFragPos);\n"
+    "    float diff = max(dot(norm, lightDir), 0.0);\n"
+    "    vec3 diffuse = diff * uLightColor;\n"
+    "\n"
+    "    vec3 result = (ambient + diffuse) * base;\n"
+    "\n"
+    "#ifdef SPEC_MAP\n"
+    "    // specular (only meshes that have a specular map pay for it)\n"
+    "    float specularStrength = 0.5;\n"
+    "    vec3 viewDir = normalize(uViewPos - vFragPos);\n"
+    "    vec3 reflectDir = reflect(-lightDir, norm);\n"
+    "    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);\n"
+    "    vec3 specMap = texture(uSpecMap1, vTex).rgb;\n"
+    "    result += specularStrength * spec * uLightColor * specMap;\n"
+    "#endif\n"
+    "\n"
+    "    FragColor = vec4(result, 1.0);\n"
+    "#endif\n"
+    "}\n";
+
+constexpr std::string_view MODEL_VERT_SOURCE =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 inPos;\n"
+    "layout (location = 1) in vec3 inNormal;\n"
+    "layout (location = 2) in vec2 inTex; \n"
+    "\n"
+    "out vec3 vFragPos;\n"
+    "out vec3 vNormal;\n"
+    "out vec2 vTex;\n"
+    "#ifdef PICK\n"
+    "flat out uint vPickId;   // ID pass (see pick_buffer.hpp)\n"
+    "#endif\n"
+    "\n"
+    "layout (std140) uniform FrameData\n"
+    "{\n"
+    "    mat4 uP;\n"
+    "    mat4 uV;\n"
+    "    mat4 uVP;\n"
+    "    vec3 uLightPos;\n"
+    "    vec3 uViewPos;\n"
+    "    vec3 uLightColor;\n"
+    "};\n"
+    "\n"
+    "// per-object records, OBJECT_TEXELS texels each (see object_buffer.hpp)\n"
+    "uniform samplerBuffer uObjects;\n"
+    "uniform int uObjectIndex;\n"
+    "\n"
+    "mat4 objectModel(int i)\n"
+    "{\n"
+    "    int b = i * 8;\n"
+    "    return mat4(texelFetch(uObjects, b), texelFetch(uObjects, b + 1),\n"
+    "                texelFetch(uObjects, b + 2), texelFetch(uObjects, b + 3));\n"
+    "}\n"
+    "\n"
+    "// inverse-transpose of the model matrix, precomputed on the CPU\n"
+    "mat3 objectNormal(int i)\n"
+    "{\n"
+    "    int b = i * 8 + 4;\n"
+    "    return mat3(texelFetch(uObjects, b).xyz, texelFetch(uObjects, b + 1).xyz,\n"
+    "                texelFetch(uObjects, b + 2).xyz);\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    mat4 M = objectModel(uObjectIndex);\n"
+    "\n"
+    "    vFragPos = vec3(M * vec4(inPos, 1.0));\n"
+    "    vNormal  = objectNormal(uObjectIndex) * inNormal;\n"
+    "    vTex     = inTex;\n"
+    "#ifdef PICK\n"
+    "    vPickId  = uint(texelFetch(uObjects, uObjectIndex * 8 + 4).w);\n"
+    "#endif\n"
+    "    gl_Position = uVP * vec4(vFragPos, 1.0);\n"
+    "}\n";
+
+constexpr std::string_view SEGMENT_FRAG_SOURCE =
+    "#version 330 core\n"
+    "// seven-segment readout evaluated per pixel: every segment is a box distance field,\n"
+    "// so a number of any shown length is a single quad\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "in vec2 vLocal;\n"
+    "\n"
+    "uniform vec2 uSize;\n"
+    "// bits 0-6: ones digit (segments a-g), 7-13: tens digit, 14: minus sign, 15: tens digit shown\n"
+    "uniform int uSegments;\n"
+    "uniform vec3 uOnColor;\n"
+    "uniform vec3 uOffColor;\n"
+    "\n"
+    "float boxDistance(vec2 p, vec2 center, vec2 halfSize)\n"
+    "{\n"
+    "    vec2 q = abs(p - center) - halfSize;\n"
+    "    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);\n"
+    "}\n"
+    "\n"
+    "// closest segment of the digit centered at 'origin': x = distance, y = its bit\n"
+    "vec2 digit(vec2 p, vec2 origin)\n"
+    "{\n"
+    "    float w = uSize.x * 0.40;\n"
+    "    float h = uSize.y * 0.75;\n"
+    "    float t = uSize.y * 0.10;\n"
+    "\n"
+    "    vec2 horiz = vec2(w, t) * 0.5;\n"
+    "    vec2 vert = vec2(t, h * 0.5) * 0.5;\n"
+    "\n"
+    "    // a, b, c, d, e, f, g\n"
+    "    float d[7];\n"
+    "    d[0] = boxDistance(p, origin + vec2(0.0, h * 0.5), horiz);\n"
+    "    d[1] = boxDistance(p, origin + vec2(w * 0.5, h * 0.25), vert);\n"
+    "    d[2] = boxDistance(p, origin + vec2(w * 0.5, -h * 0.25), vert);\n"
+    "    d[3] = boxDistance(p, origin + vec2(0.0, -h * 0.5), horiz);\n"
+    "    d[4] = boxDistance(p, origin + vec2(-w * 0.5, -h * 0.25), vert);\n"
+    "    d[5] = boxDistance(p, origin + vec2(-w * 0.5, h * 0.25), vert);\n"
+    "    d[6] = boxDistance(p, origin, horiz);\n"
+    "\n"
+    "    vec2 best = vec2(d[0], 0.0);\n"
+    "    for (int i = 1; i < 7; i++)\n"
+    "        if (d[i] < best.x) best = vec2(d[i], float(i));\n"
+    "    return best;\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    bool twoDigits = (uSegments & (1 << 15)) != 0;\n"
+    "    float dx = twoDigits ? uSize.x * 0.24 : 0.0;\n"
+    "\n"
+    "    // ones digit, then the tens digit if shown\n"
+    "    vec2 ones = digit(vLocal, vec2(dx, 0.0));\n"
+    "    bool lit = ones.x <= 0.0 && (uSegments & (1 << int(ones.y))) != 0;\n"
+    "    bool inside = ones.x <= 0.0;\n"
+    "\n"
+    "    if (twoDigits)\n"
+    "    {\n"
+    "        vec2 tens = digit(vLocal, vec2(-dx, 0.0));\n"
+    "        if (tens.x <= 0.0)\n"
+    "        {\n"
+    "            inside = true;\n"
+    "            lit = (uSegments & (1 << (7 + int(tens.y)))) != 0;\n"
+    "        }\n"
+    "    }\n"
+    "\n"
+    "    // minus sign left of the digits\n"
+    "    if ((uSegments & (1 << 14)) != 0)\n"
+    "    {\n"
+    "        float minusX = -uSize.x * 0.24 * 1.70;\n"
+    "        if (boxDistance(vLocal, vec2(minusX, 0.0), vec2(uSize.x * 0.06, uSize.y * 0.035)) <= 0.0)\n"
+    "        {\n"
+    "            inside = true;\n"
+    "            lit = true;\n"
+    "        }\n"
+    "    }\n"
+    "\n"
+    "    if (!inside) discard;\n"
+    "    FragColor = vec4(lit ? uOnColor : uOffColor, 1.0);\n"
+    "}\n";
+
+constexpr std::string_view SEGMENT_VERT_SOURCE =
+    "#version 330 core\n"
+    "// one quad per seven-segment readout (see segment.frag)\n"
+    "layout (location = 0) in vec2 inPos;\n"
+    "layout (location = 1) in vec2 inUV;\n"
+    "\n"
+    "out vec2 vLocal;\n"
+    "\n"
+    "layout (std140) uniform FrameData\n"
+    "{\n"
+    "    mat4 uP;\n"
+    "    mat4 uV;\n"
+    "    mat4 uVP;\n"
+    "    vec3 uLightPos;\n"
+    "    vec3 uViewPos;\n"
+    "    vec3 uLightColor;\n"
+    "};\n"
+    "\n"
+    "uniform mat4 uM;     // places the unit quad over the screen (translate + scale to uSize)\n"
+    "uniform vec2 uSize;  // screen width/height in world units\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vLocal = inPos * uSize;   // world units from the screen center\n"
+    "    gl_Position = uVP * (uM * vec4(inPos, 0.0, 1.0));\n"
+    "}\n";
+
+constexpr std::string_view TEX_FRAG_SOURCE =
+    "#version 330 core\n"
+    "#ifdef PICK\n"
+    "out uint FragId;   // R32UI target of the ID pass (see pick_buffer.hpp)\n"
+    "uniform int uPickId;\n"
+    "#else\n"
+    "out vec4 FragColor;\n"
+    "#endif\n"
+    "in vec2 vUV;\n"
+    "\n"
+    "uniform sampler2D uTexture;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 c = texture(uTexture, vUV);\n"
+    "    if (c.a < 0.05) discard;   // same cutout in the ID pass: only the drawn part of an icon picks\n"
+    "#ifdef PICK\n"
+    "    FragId = uint(uPickId);\n"
+    "#else\n"
+    "    FragColor = c;\n"
+    "#endif\n"
+    "}";
+
+constexpr std::string_view TEX_VERT_SOURCE =
+    "\n"
+    "#version 330 core\n"
+    "layout (location = 0) in vec2 inPos;\n"
+    "layout (location = 1) in vec2 inUV;\n"
+    "\n"
+    "out vec2 vUV;\n"
+    "\n"
+    "layout (std140) uniform FrameData\n"
+    "{\n"
+    "    mat4 uP;\n"
+    "    mat4 uV;\n"
+    "    mat4 uVP;\n"
+    "    vec3 uLightPos;\n"
+    "    vec3 uViewPos;\n"
+    "    vec3 uLightColor;\n"
+    "};\n"
+    "\n"
+    "uniform mat4 uM;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    vUV = inUV;\n"
+    "    vec4 world = uM * vec4(inPos.xy, 0.0, 1.0);\n"
+    "    gl_Position = uVP * world;\n"
+    "}";
+
+constexpr std::string_view UI_FRAG_SOURCE =
+    "#version 330 core\n"
+    "in vec2 UV;\n"
+    "out vec4 FragColor;\n"
+    "\n"
+    "uniform sampler2D uTex;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    FragColor = texture(uTex, UV);\n"
+    "}\n";
+
+constexpr std::string_view UI_VERT_SOURCE =
+    "#version 330 core\n"
+    "layout (location = 0) in vec2 inPos;\n"
+    "layout (location = 1) in vec2 inUV;\n"
+    "\n"
+    "out vec2 UV;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    UV = inUV;\n"
+    "    gl_Position = vec4(inPos, 0.0, 1.0);\n"
+    "}\n";
+
+constexpr EmbeddedShader EMBEDDED_SHADERS[] = {
+    { "basic.frag", BASIC_FRAG_SOURCE, sourceHash(BASIC_FRAG_SOURCE) },
+    { "basic.vert", BASIC_VERT_SOURCE, sourceHash(BASIC_VERT_SOURCE) },
+    { "bounds.frag", BOUNDS_FRAG_SOURCE, sourceHash(BOUNDS_FRAG_SOURCE) },
+    { "bounds.vert", BOUNDS_VERT_SOURCE, sourceHash(BOUNDS_VERT_SOURCE) },
+    { "droplets.frag", DROPLETS_FRAG_SOURCE, sourceHash(DROPLETS_FRAG_SOURCE) },
+    { "droplets_count.vert", DROPLETS_COUNT_VERT_SOURCE, sourceHash(DROPLETS_COUNT_VERT_SOURCE) },
+    { "droplets_update.vert", DROPLETS_UPDATE_VERT_SOURCE, sourceHash(DROPLETS_UPDATE_VERT_SOURCE) },
+    { "model.frag", MODEL_FRAG_SOURCE, sourceHash(MODEL_FRAG_SOURCE) },
+    { "model.vert", MODEL_VERT_SOURCE, sourceHash(MODEL_VERT_SOURCE) },
+    { "segment.frag", SEGMENT_FRAG_SOURCE, sourceHash(SEGMENT_FRAG_SOURCE) },
+    { "segment.vert", SEGMENT_VERT_SOURCE, sourceHash(SEGMENT_VERT_SOURCE) },
+    { "tex.frag", TEX_FRAG_SOURCE, sourceHash(TEX_FRAG_SOURCE) },
+    { "tex.vert", TEX_VERT_SOURCE, sourceHash(TEX_VERT_SOURCE) },
+    { "ui.frag", UI_FRAG_SOURCE, sourceHash(UI_FRAG_SOURCE) },
+    { "ui.vert", UI_VERT_SOURCE, sourceHash(UI_VERT_SOURCE) },
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include "fixed_step.hpp"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+
+// Pieces for running the simulation on its own thread, next to the render loop.
+//  - SpscQueue: input commands, render thread -> simulation thread
+//  - SnapshotBuffer: finished simulation states, simulation thread -> render thread
+//  - SimThread: the thread itself, ticking a FixedStep in real time
+// neither side ever blocks the other: no locks, only atomics.
+
+// Bounded single-producer single-consumer ring. push() only from one thread, pop() only
+// from one other thread. N must be a power of two.
+template<class T, size_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+public:
+    // false when full (the item is dropped)
+    bool push(const T& item)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        items[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // false when empty
+    bool pop(T& item)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = items[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[N];
+    alignas(64) std::atomic<size_t> head{ 0 };   // next to pop, written by the consumer
+    alignas(64) std::atomic<size_t> tail{ 0 };   // next to push, written by the producer
+};
+
+// Latest-value exchange of whole snapshots between one writer and one reader.
+// the writer fills back() and publish()es it; the reader acquire()s the newest published one
+// and reads front() until its next acquire(). one slot each for writer and reader (the double
+// buffer) plus one in the middle that publish/acquire swap with a single atomic exchange, so
+// neither side ever waits for the other; snapshots the reader never picked up are overwritten.
+// a slot handed back to the writer holds an older snapshot: back() has to be rewritten fully.
+template<class T>
+class SnapshotBuffer {
+public:
+    // writer side
+    T& back()
+    {
+        return slots[writing];
+    }
+
+    void publish()
+    {
+        writing = middle.exchange(writing | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // reader side: true when front() changed
+    bool acquire()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        reading = middle.exchange(reading, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& front() const
+    {
+        return slots[reading];
+    }
+
+private:
+    static constexpr unsigned int INDEX = 3u;
+    static constexpr unsigned int FRESH = 4u;   // middle slot published, not yet acquired
+
+    T slots[3];
+    unsigned int writing = 0;
+    unsigned int reading = 1;
+    std::atomic<unsigned int> middle{ 2u };
+};
+
+// The simulation thread: frame(ticks, dt, lastTick) is called in a loop with the number of
+// fixed ticks due since the previous call (0 is possible, e.g. to pick up input) and the
+// real time the last of them belongs to, for interpolation on the render side. between calls
+// the thread sleeps until the next tick is due.
+class SimThread {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ~SimThread()
+    {
+        stop();
+    }
+
+    template<class F>
+    void start(FixedStep clock, F frame)
+    {
+        stop();
+        running.store(true, std::memory_order_release);
+        thread = std::thread([this, clock, frame]() mutable {
+            Clock::time_point last = Clock::now();
+            while (running.load(std::memory_order_acquire))
+            {
+                const Clock::time_point now = Clock::now();
+                const int ticks = clock.advance(std::chrono::duration<float>(now - last).count());
+                last = now;
+
+                const float behind = clock.alpha() * clock.step();
+                frame(ticks, clock.step(), now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(behind)));
+
+                std::this_thread::sleep_for(std::chrono::duration<float>(clock.step() - behind));
+            }
+        });
+    }
+
+    void stop()
+    {
+        running.store(false, std::memory_order_release);
+        if (thread.joinable()) thread.join();
+    }
+
+private:
+    std::thread thread;
+    std::atomic<bool> running{ false };
+};
+
+#endif
@@ -0,0 +1,249 @@
+#ifndef STATIC_GEOMETRY_H
+#define STATIC_GEOMETRY_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "object_buffer.hpp"
+#include "culling.hpp"
+#include "occlusion_culler.hpp"
+#include "shader_variants.hpp"
+
+#include <vector>
+#include <map>
+#include <array>
+#include <cfloat>
+#include <cstdint>
+
+// Geometry that never moves, baked into world space once.
+// add() only records a mesh and its placement. bake() transforms every vertex on the CPU,
+// merges the triangles by material (color + shader variant) into one indexed vertex buffer
+// and is free unless the static set changed since the last call.
+// per frame that leaves one object record (identity transform, material color) and one
+// glDrawElements per material.
+class StaticGeometry {
+public:
+    // vertices: 'count' x (position, normal) as 6 floats, triangle list. only the pointer is
+    // kept (every rebake reads it again), so it must stay valid: static tables such as the cube.
+    // occluder: also rendered into the CPU occlusion buffer every frame
+    // pickId: see ObjectBuffer::pickId. a material answers to the pick id of its first entry
+    int add(const float* vertices, int count, const glm::mat4& M, const glm::vec3& color,
+        unsigned int features = 0, bool occluder = false, uint32_t pickId = 0)
+    {
+        Entry e;
+        e.vertices = vertices;
+        e.count = count;
+        e.M = M;
+        e.color = color;
+        e.features = features;
+        e.occluder = occluder;
+        e.pickId = pickId;
+        e.lo = glm::vec3(FLT_MAX);
+        e.hi = glm::vec3(-FLT_MAX);
+        for (int i = 0; i < count; i++)
+        {
+            glm::vec3 p(vertices[i * 6 + 0], vertices[i * 6 + 1], vertices[i * 6 + 2]);
+            e.lo = glm::min(e.lo, p);
+            e.hi = glm::max(e.hi, p);
+        }
+        entries.push_back(e);
+        dirty = true;
+        return (int)entries.size() - 1;
+    }
+
+    void remove(int id)
+    {
+        if (id < 0 || id >= (int)entries.size() || entries[id].removed) return;
+        entries[id].removed = true;
+        dirty = true;
+    }
+
+    void clear()
+    {
+        entries.clear();
+        dirty = true;
+    }
+
+    // rebuilds the vertex/index buffers if anything was added or removed
+    void bake()
+    {
+        if (!dirty) return;
+        dirty = false;
+
+        if (!VAO)
+        {
+            glGenVertexArrays(1, &VAO);
+            glGenBuffers(1, &VBO);
+            glGenBuffers(1, &EBO);
+
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+            glEnableVertexAttribArray(1);
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        // material of every entry, in order of first appearance
+        materials.clear();
+        std::vector<int> entryMaterial(entries.size(), -1);
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const Entry& e = entries[i];
+            if (e.removed) continue;
+            int m = 0;
+            while (m < (int)materials.size() && !(materials[m].color == e.color && materials[m].features == e.features)) m++;
+            if (m == (int)materials.size())
+            {
+                Material mat;
+                mat.color = e.color;
+                mat.features = e.features;
+                mat.pickId = e.pickId;
+                mat.lo = glm::vec3(FLT_MAX);
+                mat.hi = glm::vec3(-FLT_MAX);
+                materials.push_back(mat);
+            }
+            entryMaterial[i] = m;
+        }
+
+        // one material after the other, so each is a contiguous index range
+        std::vector<float> verts;
+        std::vector<uint32_t> indices;
+        for (size_t m = 0; m < materials.size(); m++)
+        {
+            Material& mat = materials[m];
+            mat.firstIndex = (int)indices.size();
+            for (size_t i = 0; i < entries.size(); i++)
+            {
+                if (entryMaterial[i] == (int)m)
+                    appendEntry(entries[i], mat, verts, indices);
+            }
+            mat.indexCount = (int)indices.size() - mat.firstIndex;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(VAO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+
+        vertexCount = (int)verts.size() / 6;
+        indexCount = (int)indices.size();
+    }
+
+    // per frame, while recording: one record + bounds per material, occluders into the CPU buffer
+    void submit(ObjectBuffer& objects, FrustumCuller& culler, OcclusionCuller& occlusion)
+    {
+        const uint32_t pickId = objects.pickId;
+        for (Material& mat : materials)
+        {
+            objects.pickId = mat.pickId;
+            mat.object = objects.push(glm::mat4(1.0f), mat.color);
+            mat.bounds = culler.add(glm::mat4(1.0f), mat.lo, mat.hi);
+        }
+        for (const Entry& e : entries)
+        {
+            if (e.occluder && !e.removed)
+                occlusion.addOccluder(e.M, e.lo, e.hi);
+        }
+        objects.pickId = pickId;
+    }
+
+    // expects the object buffer uploaded + bound; 'objectIndex' is the uniform the variants read
+    void draw(ShaderVariants& shaders, UniformKey objectIndex, const FrustumCuller& culler)
+    {
+        glBindVertexArray(VAO);
+        for (const Material& mat : materials)
+        {
+            if (mat.indexCount == 0 || !culler.visible(mat.bounds)) continue;
+            Shader& shader = shaders.get(mat.features);
+            shader.use();
+            shader.setInt(objectIndex, mat.object);
+            glDrawElements(GL_TRIANGLES, mat.indexCount, GL_UNSIGNED_INT, (void*)(mat.firstIndex * sizeof(uint32_t)));
+        }
+        glBindVertexArray(0);
+    }
+
+    int materialCount() const
+    {
+        return (int)materials.size();
+    }
+
+    // after deduplication, for the startup report
+    int bakedVertices() const
+    {
+        return vertexCount;
+    }
+
+    int bakedIndices() const
+    {
+        return indexCount;
+    }
+
+private:
+    struct Entry {
+        const float* vertices;
+        int count;
+        glm::mat4 M;
+        glm::vec3 color;
+        unsigned int features;
+        bool occluder;
+        uint32_t pickId;
+        bool removed = false;
+        glm::vec3 lo, hi;   // local box
+    };
+    struct Material {
+        glm::vec3 color;
+        unsigned int features;
+        uint32_t pickId = 0;
+        int firstIndex = 0;
+        int indexCount = 0;
+        glm::vec3 lo, hi;   // world box
+        int object = -1;    // this frame's record
+        int bounds = -1;    // this frame's sphere
+    };
+    std::vector<Entry> entries;
+    std::vector<Material> materials;
+    bool dirty = false;
+
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    int vertexCount = 0;
+    int indexCount = 0;
+
+    // world-space copy of one entry; identical (position, normal) pairs of the source share a vertex
+    static void appendEntry(const Entry& e, Material& mat, std::vector<float>& verts, std::vector<uint32_t>& indices)
+    {
+        const glm::mat3 N = normalMatrix(e.M);
+        std::map<std::array<float, 6>, uint32_t> shared;
+        for (int i = 0; i < e.count; i++)
+        {
+            std::array<float, 6> key;
+            for (int k = 0; k < 6; k++) key[k] = e.vertices[i * 6 + k];
+
+            auto found = shared.find(key);
+            if (found != shared.end())
+            {
+                indices.push_back(found->second);
+                continue;
+            }
+
+            glm::vec3 p = glm::vec3(e.M * glm::vec4(key[0], key[1], key[2], 1.0f));
+            glm::vec3 n = glm::normalize(N * glm::vec3(key[3], key[4], key[5]));
+            uint32_t index = (uint32_t)(verts.size() / 6);
+            verts.push_back(p.x); verts.push_back(p.y); verts.push_back(p.z);
+            verts.push_back(n.x); verts.push_back(n.y); verts.push_back(n.z);
+            mat.lo = glm::min(mat.lo, p);
+            mat.hi = glm::max(mat.hi, p);
+
+            shared.emplace(key, index);
+            indices.push_back(index);
+        }
+    }
+};
+
+#endif
@@ -1,5 +1,10 @@
 #version 330 core
+#ifdef PICK
+out uint FragId;   // R32UI target of the ID pass (see pick_buffer.hpp)
+uniform int uPickId;
+#else
 out vec4 FragColor;
+#endif
 in vec2 vUV;
 
 uniform sampler2D uTexture;
@@ -7,6 +12,10 @@ uniform sampler2D uTexture;
 void main()
 {
     vec4 c = texture(uTexture, vUV);
-    if (c.a < 0.05) discard;
+    if (c.a < 0.05) discard;   // same cutout in the ID pass: only the drawn part of an icon picks
+#ifdef PICK
+    FragId = uint(uPickId);
+#else
     FragColor = c;
+#endif
 }
\ No newline at end of file
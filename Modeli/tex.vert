@@ -5,13 +5,21 @@ layout (location = 1) in vec2 inUV;
 
 out vec2 vUV;
 
+layout (std140) uniform FrameData
+{
+    mat4 uP;
+    mat4 uV;
+    mat4 uVP;
+    vec3 uLightPos;
+    vec3 uViewPos;
+    vec3 uLightColor;
+};
+
 uniform mat4 uM;
-uniform mat4 uV;
-uniform mat4 uP;
 
 void main()
 {
     vUV = inUV;
     vec4 world = uM * vec4(inPos.xy, 0.0, 1.0);
-    gl_Position = uP * uV * world;
+    gl_Position = uVP * world;
 }
\ No newline at end of file
@@ -0,0 +1,394 @@
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include <glm/glm.hpp>
+
+#include "parallel.hpp"
+
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <algorithm>
+
+#if defined(__AVX__)
+#define THERMAL_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define THERMAL_SSE 1
+#include <emmintrin.h>
+#endif
+
+// cache blocks of the stencil: rows x planes marched per task, so the three planes a row
+// reads stay in cache while the block moves through z
+const int THERMAL_BLOCK_Y = 8;
+const int THERMAL_BLOCK_Z = 16;
+
+struct ThermalParams {
+    float diffusivity = 0.12f;   // m^2/s, air plus turbulent mixing
+    float wallMix = 0.003f;      // how far each wall cell leans towards 'ambient' (0 = insulated)
+    float ambient = 31.0f;       // outside the room
+    float sourceRate = 6.0f;     // 1/s, outlet cells relaxing to the supply temperature
+};
+
+// Air temperature of the room on a voxel grid.
+//   dT/dt = k * laplacian(T) - u . grad(T)
+// explicit 7-point diffusion plus first-order upwind advection along a fixed flow field (the
+// AC jet and the room circulation it drives, scaled by the fan), substepped to stay stable.
+// cells are SoA with a one-cell halo: the walls, refilled every substep half way to
+// 'ambient' (heat leaking out). a row is 8 (AVX) or 4 (SSE2) cells at a time, blocks of
+// rows x planes are spread over the thread pool.
+class ThermalField {
+public:
+    // the box [lo, hi] in cells of about 'cell' world units
+    void init(const glm::vec3& lo, const glm::vec3& hi, float cell, float temperature)
+    {
+        origin = lo;
+        glm::vec3 size = hi - lo;
+        nx = std::max(2, (int)std::round(size.x / cell));
+        ny = std::max(2, (int)std::round(size.y / cell));
+        nz = std::max(2, (int)std::round(size.z / cell));
+        h = size / glm::vec3((float)nx, (float)ny, (float)nz);
+
+        sx = 1;
+        sy = nx + 2;
+        sz = (size_t)(nx + 2) * (ny + 2);
+        const size_t total = sz * (nz + 2);
+        T.assign(total, temperature);
+        next.assign(total, temperature);
+        u.assign(total, 0.0f);
+        v.assign(total, 0.0f);
+        w.assign(total, 0.0f);
+        sources.clear();
+    }
+
+    void reset(float temperature)
+    {
+        std::fill(T.begin(), T.end(), temperature);
+    }
+
+    // flow of the fan at full speed: a jet out of 'outlet' along 'dir' plus the roll it sets
+    // up in the room (down the outlet's wall, along the floor, back under the ceiling).
+    // cells within 'radius' of the outlet take the supply temperature
+    void setOutlet(const glm::vec3& outlet, const glm::vec3& dir, float jetSpeed, float rollSpeed, float radius)
+    {
+        const glm::vec3 d = glm::normalize(dir);
+        const glm::vec3 extent = h * glm::vec3((float)nx, (float)ny, (float)nz);
+        // the roll turns in the plane of the jet: along its horizontal direction and y
+        glm::vec3 along(d.x, 0.0f, d.z);
+        along = glm::length(along) > 1e-4f ? glm::normalize(along) : glm::vec3(0.0f, 0.0f, 1.0f);
+        const float L = std::fabs(along.x) * extent.x + std::fabs(along.z) * extent.z;
+        const float H = extent.y;
+        const float A = rollSpeed * H / 3.1415926f;   // stream function amplitude
+
+        sources.clear();
+        for (int z = 1; z <= nz; z++)
+        {
+            for (int y = 1; y <= ny; y++)
+            {
+                for (int x = 1; x <= nx; x++)
+                {
+                    const size_t i = index(x, y, z);
+                    const glm::vec3 p = cellCenter(x, y, z);
+
+                    // roll: stream function A sin(pi y'/H) sin(pi s/L), s measured from the
+                    // wall the jet comes out of, so the flow is divergence free
+                    const glm::vec3 local = p - origin;
+                    float s = glm::dot(local, along);
+                    if (along.x + along.z < 0.0f) s += L;
+                    const float yy = local.y;
+                    const float cosY = std::cos(3.1415926f * yy / H), sinY = std::sin(3.1415926f * yy / H);
+                    const float cosS = std::cos(3.1415926f * s / L), sinS = std::sin(3.1415926f * s / L);
+                    glm::vec3 vel = along * (A * 3.1415926f / H * cosY * sinS);
+                    vel.y = -A * 3.1415926f / L * sinY * cosS;
+
+                    // jet: spreads linearly, slows down with distance
+                    const glm::vec3 r = p - outlet;
+                    const float t = glm::dot(r, d);
+                    if (t > 0.0f)
+                    {
+                        const float width = 0.15f + 0.2f * t;
+                        const float radial2 = glm::dot(r - d * t, r - d * t);
+                        vel += d * (jetSpeed * 0.5f / (0.5f + t) * std::exp(-radial2 / (width * width)));
+                    }
+
+                    u[i] = vel.x; v[i] = vel.y; w[i] = vel.z;
+                    if (glm::length(r) <= radius) sources.push_back(i);
+                }
+            }
+        }
+        if (sources.empty()) sources.push_back(nearestCell(outlet));
+
+        maxSpeed = 0.0f;
+        for (size_t i = 0; i < u.size(); i++)
+            maxSpeed = std::max(maxSpeed, std::fabs(u[i]) / h.x + std::fabs(v[i]) / h.y + std::fabs(w[i]) / h.z);
+    }
+
+    // advances 'dt'. fan: 0 (off) .. 1, supply: temperature at the outlet while the fan runs
+    void step(float dt, float fan, float supply, const ThermalParams& params, ThreadPool* pool = nullptr)
+    {
+        // explicit limit: the weights of the neighbours, 2k*dt*sum(1/h^2) + dt*sum(|u|/h), stay
+        // below 1 (no new extremes), with some margin
+        const float invH2 = 1.0f / (h.x * h.x) + 1.0f / (h.y * h.y) + 1.0f / (h.z * h.z);
+        const float rate = 2.0f * params.diffusivity * invH2 + fan * maxSpeed;
+        const int substeps = std::max(1, (int)std::ceil(dt * rate / 0.9f));
+        const float sub = dt / substeps;
+
+        Coefficients c;
+        c.kx = params.diffusivity * sub / (h.x * h.x);
+        c.ky = params.diffusivity * sub / (h.y * h.y);
+        c.kz = params.diffusivity * sub / (h.z * h.z);
+        c.ax = fan * sub / h.x;
+        c.ay = fan * sub / h.y;
+        c.az = fan * sub / h.z;
+
+        const int blocksY = (ny + THERMAL_BLOCK_Y - 1) / THERMAL_BLOCK_Y;
+        const int blocksZ = (nz + THERMAL_BLOCK_Z - 1) / THERMAL_BLOCK_Z;
+        for (int k = 0; k < substeps; k++)
+        {
+            fillWalls(params.ambient, params.wallMix);
+
+            auto blocks = [&](size_t begin, size_t end) {
+                for (size_t b = begin; b < end; b++)
+                {
+                    const int by = (int)(b % blocksY), bz = (int)(b / blocksY);
+                    const int y0 = 1 + by * THERMAL_BLOCK_Y, y1 = std::min(ny, y0 + THERMAL_BLOCK_Y - 1);
+                    const int z0 = 1 + bz * THERMAL_BLOCK_Z, z1 = std::min(nz, z0 + THERMAL_BLOCK_Z - 1);
+                    for (int z = z0; z <= z1; z++)
+                        for (int y = y0; y <= y1; y++)
+                            stepRow(index(1, y, z), c, fan > 0.0f);
+                }
+            };
+            const size_t count = (size_t)blocksY * blocksZ;
+            if (pool) pool->parallelFor(count, 1, blocks);
+            else      blocks(0, count);
+
+            T.swap(next);
+
+            if (fan > 0.0f)
+            {
+                const float relax = std::min(1.0f, params.sourceRate * fan * sub);
+                for (size_t i : sources) T[i] += (supply - T[i]) * relax;
+            }
+        }
+    }
+
+    // trilinear, clamped to the room
+    float sample(const glm::vec3& p) const
+    {
+        const glm::vec3 g = (p - origin) / h;
+        const float gx = std::clamp(g.x - 0.5f, 0.0f, nx - 1.001f);
+        const float gy = std::clamp(g.y - 0.5f, 0.0f, ny - 1.001f);
+        const float gz = std::clamp(g.z - 0.5f, 0.0f, nz - 1.001f);
+        const int x = (int)gx, y = (int)gy, z = (int)gz;
+        const float fx = gx - x, fy = gy - y, fz = gz - z;
+        const size_t i = index(x + 1, y + 1, z + 1);
+        auto lerp = [](float a, float b, float t) { return a + (b - a) * t; };
+        const float c00 = lerp(T[i], T[i + sx], fx), c10 = lerp(T[i + sy], T[i + sy + sx], fx);
+        const float c01 = lerp(T[i + sz], T[i + sz + sx], fx), c11 = lerp(T[i + sz + sy], T[i + sz + sy + sx], fx);
+        return lerp(lerp(c00, c10, fy), lerp(c01, c11, fy), fz);
+    }
+
+    size_t cells() const
+    {
+        return (size_t)nx * ny * nz;
+    }
+
+    int sizeX() const { return nx; }
+    int sizeY() const { return ny; }
+    int sizeZ() const { return nz; }
+
+private:
+    struct Coefficients {
+        float kx, ky, kz;   // diffusivity * dt / h^2
+        float ax, ay, az;   // fan * dt / h
+    };
+
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 h = glm::vec3(1.0f);
+    int nx = 0, ny = 0, nz = 0;
+    size_t sx = 1, sy = 0, sz = 0;
+    std::vector<float> T, next;   // padded by one cell on every side
+    std::vector<float> u, v, w;   // flow at full fan speed
+    std::vector<size_t> sources;
+    float maxSpeed = 0.0f;        // max of sum(|u|/h), for the step limit
+
+    size_t index(int x, int y, int z) const
+    {
+        return (size_t)z * sz + (size_t)y * sy + (size_t)x;
+    }
+
+    glm::vec3 cellCenter(int x, int y, int z) const
+    {
+        return origin + h * glm::vec3(x - 0.5f, y - 0.5f, z - 0.5f);
+    }
+
+    size_t nearestCell(const glm::vec3& p) const
+    {
+        const glm::vec3 g = (p - origin) / h;
+        const int x = std::clamp((int)std::floor(g.x) + 1, 1, nx);
+        const int y = std::clamp((int)std::floor(g.y) + 1, 1, ny);
+        const int z = std::clamp((int)std::floor(g.z) + 1, 1, nz);
+        return index(x, y, z);
+    }
+
+    // halo = its interior neighbour, pulled towards the outside temperature
+    void fillWalls(float ambient, float mix)
+    {
+        auto wall = [&](size_t halo, size_t inside) { T[halo] = T[inside] + (ambient - T[inside]) * mix; };
+        for (int z = 1; z <= nz; z++)
+        {
+            for (int y = 1; y <= ny; y++)
+            {
+                wall(index(0, y, z), index(1, y, z));
+                wall(index(nx + 1, y, z), index(nx, y, z));
+            }
+            for (int x = 1; x <= nx; x++)
+            {
+                wall(index(x, 0, z), index(x, 1, z));
+                wall(index(x, ny + 1, z), index(x, ny, z));
+            }
+        }
+        for (int y = 1; y <= ny; y++)
+        {
+            for (int x = 1; x <= nx; x++)
+            {
+                wall(index(x, y, 0), index(x, y, 1));
+                wall(index(x, y, nz + 1), index(x, y, nz));
+            }
+        }
+    }
+
+    // one interior row, x = 1..nx starting at 'row'
+    void stepRow(size_t row, const Coefficients& c, bool advect)
+    {
+        const float* t = &T[row];
+        float* out = &next[row];
+        const float* pu = &u[row];
+        const float* pv = &v[row];
+        const float* pw = &w[row];
+        int x = 0;
+
+#if defined(THERMAL_AVX)
+        const __m256 kx = _mm256_set1_ps(c.kx), ky = _mm256_set1_ps(c.ky), kz = _mm256_set1_ps(c.kz);
+        const __m256 ax = _mm256_set1_ps(c.ax), ay = _mm256_set1_ps(c.ay), az = _mm256_set1_ps(c.az);
+        const __m256 zero = _mm256_setzero_ps(), two = _mm256_set1_ps(2.0f);
+        for (; x + 8 <= nx; x += 8)
+        {
+            const __m256 m = _mm256_loadu_ps(t + x);
+            const __m256 l = _mm256_loadu_ps(t + x - sx), r = _mm256_loadu_ps(t + x + sx);
+            const __m256 d = _mm256_loadu_ps(t + x - sy), up = _mm256_loadu_ps(t + x + sy);
+            const __m256 b = _mm256_loadu_ps(t + x - sz), f = _mm256_loadu_ps(t + x + sz);
+            const __m256 m2 = _mm256_mul_ps(m, two);
+
+            __m256 acc = _mm256_mul_ps(kx, _mm256_sub_ps(_mm256_add_ps(l, r), m2));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(ky, _mm256_sub_ps(_mm256_add_ps(d, up), m2)));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(kz, _mm256_sub_ps(_mm256_add_ps(b, f), m2)));
+            if (advect)
+            {
+                // upwind: positive speed looks back, negative looks ahead
+                const __m256 vu = _mm256_loadu_ps(pu + x), vv = _mm256_loadu_ps(pv + x), vw = _mm256_loadu_ps(pw + x);
+                __m256 adv = _mm256_mul_ps(ax, _mm256_add_ps(_mm256_mul_ps(_mm256_max_ps(vu, zero), _mm256_sub_ps(m, l)),
+                    _mm256_mul_ps(_mm256_min_ps(vu, zero), _mm256_sub_ps(r, m))));
+                adv = _mm256_add_ps(adv, _mm256_mul_ps(ay, _mm256_add_ps(_mm256_mul_ps(_mm256_max_ps(vv, zero), _mm256_sub_ps(m, d)),
+                    _mm256_mul_ps(_mm256_min_ps(vv, zero), _mm256_sub_ps(up, m)))));
+                adv = _mm256_add_ps(adv, _mm256_mul_ps(az, _mm256_add_ps(_mm256_mul_ps(_mm256_max_ps(vw, zero), _mm256_sub_ps(m, b)),
+                    _mm256_mul_ps(_mm256_min_ps(vw, zero), _mm256_sub_ps(f, m)))));
+                acc = _mm256_sub_ps(acc, adv);
+            }
+            _mm256_storeu_ps(out + x, _mm256_add_ps(m, acc));
+        }
+#elif defined(THERMAL_SSE)
+        const __m128 kx = _mm_set1_ps(c.kx), ky = _mm_set1_ps(c.ky), kz = _mm_set1_ps(c.kz);
+        const __m128 ax = _mm_set1_ps(c.ax), ay = _mm_set1_ps(c.ay), az = _mm_set1_ps(c.az);
+        const __m128 zero = _mm_setzero_ps(), two = _mm_set1_ps(2.0f);
+        for (; x + 4 <= nx; x += 4)
+        {
+            const __m128 m = _mm_loadu_ps(t + x);
+            const __m128 l = _mm_loadu_ps(t + x - sx), r = _mm_loadu_ps(t + x + sx);
+            const __m128 d = _mm_loadu_ps(t + x - sy), up = _mm_loadu_ps(t + x + sy);
+            const __m128 b = _mm_loadu_ps(t + x - sz), f = _mm_loadu_ps(t + x + sz);
+            const __m128 m2 = _mm_mul_ps(m, two);
+
+            __m128 acc = _mm_mul_ps(kx, _mm_sub_ps(_mm_add_ps(l, r), m2));
+            acc = _mm_add_ps(acc, _mm_mul_ps(ky, _mm_sub_ps(_mm_add_ps(d, up), m2)));
+            acc = _mm_add_ps(acc, _mm_mul_ps(kz, _mm_sub_ps(_mm_add_ps(b, f), m2)));
+            if (advect)
+            {
+                const __m128 vu = _mm_loadu_ps(pu + x), vv = _mm_loadu_ps(pv + x), vw = _mm_loadu_ps(pw + x);
+                __m128 adv = _mm_mul_ps(ax, _mm_add_ps(_mm_mul_ps(_mm_max_ps(vu, zero), _mm_sub_ps(m, l)),
+                    _mm_mul_ps(_mm_min_ps(vu, zero), _mm_sub_ps(r, m))));
+                adv = _mm_add_ps(adv, _mm_mul_ps(ay, _mm_add_ps(_mm_mul_ps(_mm_max_ps(vv, zero), _mm_sub_ps(m, d)),
+                    _mm_mul_ps(_mm_min_ps(vv, zero), _mm_sub_ps(up, m)))));
+                adv = _mm_add_ps(adv, _mm_mul_ps(az, _mm_add_ps(_mm_mul_ps(_mm_max_ps(vw, zero), _mm_sub_ps(m, b)),
+                    _mm_mul_ps(_mm_min_ps(vw, zero), _mm_sub_ps(f, m)))));
+                acc = _mm_sub_ps(acc, adv);
+            }
+            _mm_storeu_ps(out + x, _mm_add_ps(m, acc));
+        }
+#endif
+        for (; x < nx; x++)
+        {
+            const float m = t[x];
+            const float l = t[x - sx], r = t[x + sx], d = t[x - sy], up = t[x + sy], b = t[x - sz], f = t[x + sz];
+            float acc = c.kx * (l + r - 2.0f * m) + c.ky * (d + up - 2.0f * m) + c.kz * (b + f - 2.0f * m);
+            if (advect)
+            {
+                acc -= c.ax * (std::max(pu[x], 0.0f) * (m - l) + std::min(pu[x], 0.0f) * (r - m));
+                acc -= c.ay * (std::max(pv[x], 0.0f) * (m - d) + std::min(pv[x], 0.0f) * (up - m));
+                acc -= c.az * (std::max(pw[x], 0.0f) * (m - b) + std::min(pw[x], 0.0f) * (f - m));
+            }
+            out[x] = m + acc;
+        }
+    }
+};
+
+// --bench thermal: one substep of the stencil from coarse to fine grids, on 1 thread and on all
+static void runThermalBenchmark()
+{
+    const glm::vec3 lo(-3.0f, 0.0f, -3.0f), hi(3.0f, 3.0f, 3.0f);
+    const float cellSizes[] = { 0.25f, 0.125f, 0.0625f, 0.04f, 0.03f };
+
+#if defined(THERMAL_AVX)
+    const char* isa = "AVX";
+#elif defined(THERMAL_SSE)
+    const char* isa = "SSE2";
+#else
+    const char* isa = "scalar";
+#endif
+    std::cout << "thermal stencil benchmark (" << isa << ", " << hardwareThreads() << " hardware threads)" << std::endl;
+    std::cout << std::setw(16) << "grid" << std::setw(9) << "threads"
+        << std::setw(14) << "Mcells/s" << std::setw(10) << "speedup" << std::endl;
+
+    ThermalParams params;
+    for (float cell : cellSizes)
+    {
+        ThermalField field;
+        field.init(lo, hi, cell, 31.0f);
+        field.setOutlet(glm::vec3(0.0f, 2.2f, -2.7f), glm::vec3(0.0f, -0.5f, 1.0f), 1.5f, 0.4f, 0.2f);
+        const size_t cells = field.cells();
+
+        double single = 0.0;
+        forEachThreadCount([&](unsigned int threads, ThreadPool* pool) {
+            // dt small enough for one substep on every grid; ~200M cell updates, at least 3 steps
+            const float dt = 1e-4f;
+            const int steps = (int)std::max<size_t>(3, 200000000 / cells);
+            field.step(dt, 1.0f, 18.0f, params, pool);   // warm up
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (int s = 0; s < steps; s++) field.step(dt, 1.0f, 18.0f, params, pool);
+            auto t1 = std::chrono::steady_clock::now();
+
+            double rate = (double)steps * cells / std::chrono::duration<double>(t1 - t0).count() * 1e-6;
+            if (threads == 1) single = rate;
+            std::string grid = std::to_string(field.sizeX()) + "x" + std::to_string(field.sizeY()) + "x" + std::to_string(field.sizeZ());
+            std::cout << std::setw(16) << grid << std::setw(9) << threads
+                << std::setw(14) << std::fixed << std::setprecision(1) << rate
+                << std::setw(9) << std::setprecision(2) << rate / single << "x" << std::endl;
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+# Generates shaders_embedded.hpp: every *.vert / *.frag / *.geom next to the project,
+# as constexpr string data plus its compile-time hash (see shader_sources.hpp).
+#
+#   python tools/embed_shaders.py [project dir]
+#
+# Run by the pre-build step; the output is only rewritten when it changes, so an
+# unchanged shader set doesn't trigger a rebuild.
+import os
+import sys
+
+EXTENSIONS = (".vert", ".frag", ".geom")
+OUTPUT = "shaders_embedded.hpp"
+
+
+def literal(data):
+    # one C string literal per source line; everything outside printable ASCII is
+    # escaped so the header doesn't depend on the compiler's source charset
+    lines = []
+    for line in data.split(b"\n"):
+        out = []
+        for b in line:
+            c = chr(b)
+            if c == "\\" or c == '"':
+                out.append("\\" + c)
+            elif c == "\t":
+                out.append("\\t")
+            elif 32 <= b < 127:
+                out.append(c)
+            else:
+                out.append("\\%03o" % b)
+        lines.append("".join(out))
+    # the last element is what follows the final newline (usually nothing)
+    body = ['    "%s\\n"' % l for l in lines[:-1]]
+    if lines[-1]:
+        body.append('    "%s"' % lines[-1])
+    if not body:
+        body.append('    ""')
+    return "\n".join(body)
+
+
+def identifier(name):
+    return "".join(c.upper() if c.isalnum() else "_" for c in name)
+
+
+def main():
+    root = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), ".."))
+    names = sorted(f for f in os.listdir(root) if f.endswith(EXTENSIONS))
+
+    out = [
+        "// generated by tools/embed_shaders.py from the shader sources - do not edit",
+        "#ifndef SHADERS_EMBEDDED_H",
+        "#define SHADERS_EMBEDDED_H",
+        "",
+    ]
+    for name in names:
+        with open(os.path.join(root, name), "rb") as f:
+            # same text std::ifstream gives on Windows, so disk and embedded keys agree
+            data = f.read().replace(b"\r\n", b"\n")
+        out.append("constexpr std::string_view %s_SOURCE =" % identifier(name))
+        out.append(literal(data) + ";")
+        out.append("")
+
+    # constexpr array: the hashes are evaluated by the compiler, not at startup
+    out.append("constexpr EmbeddedShader EMBEDDED_SHADERS[] = {")
+    for name in names:
+        src = identifier(name) + "_SOURCE"
+        out.append('    { "%s", %s, sourceHash(%s) },' % (name, src, src))
+    out.append("};")
+    out.append("")
+    out.append("#endif")
+    text = "\n".join(out) + "\n"
+
+    path = os.path.join(root, OUTPUT)
+    try:
+        with open(path, "r", newline="") as f:
+            if f.read() == text:
+                return
+    except OSError:
+        pass
+    with open(path, "w", newline="\n") as f:
+        f.write(text)
+    print("embed_shaders: %d shaders -> %s" % (len(names), OUTPUT))
+
+
+if __name__ == "__main__":
+    main()
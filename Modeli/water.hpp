@@ -0,0 +1,301 @@
+#ifndef WATER_H
+#define WATER_H
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "object_buffer.hpp"
+#include "culling.hpp"
+#include "shader_variants.hpp"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WATER_SSE 1
+#include <emmintrin.h>
+#endif
+
+// texture unit of the ripple heightfield (next to the object buffer)
+const unsigned int WATER_RIPPLE_UNIT = 9;
+
+const int   WATER_GRID = 64;               // heightfield cells per side, over the disc's bounding square
+const float WATER_STEP = 1.0f / 60.0f;     // fixed simulation step (s)
+const int   WATER_MAX_STEPS = 4;           // per update, after a hitch the rest is dropped
+const float WATER_DAMPING = 0.985f;
+const float WATER_IDLE_EPS = 1e-3f;        // below this everywhere the surface counts as flat
+const float WATER_RIPPLE_HEIGHT = 0.012f;  // world units per heightfield unit
+
+// Ripples on the water surface: the classic two-buffer wave equation
+//   next = (left + right + up + down) / 2 - previous, damped
+// on a WATER_GRID^2 heightfield. cells outside the unit disc are held at 0, so waves reflect
+// off the basin wall. 4 cells per step with SSE2.
+// once every cell is back under WATER_IDLE_EPS the field is zeroed and update() does nothing
+// until the next impact.
+class WaterRipples {
+public:
+    WaterRipples()
+        : cur(WATER_GRID * WATER_GRID, 0.0f), prev(WATER_GRID * WATER_GRID, 0.0f), mask(WATER_GRID * WATER_GRID, 0.0f)
+    {
+        for (int y = 0; y < WATER_GRID; y++)
+        {
+            for (int x = 0; x < WATER_GRID; x++)
+            {
+                glm::vec2 p = cellToDisc(x, y);
+                bool border = x == 0 || y == 0 || x == WATER_GRID - 1 || y == WATER_GRID - 1;
+                mask[y * WATER_GRID + x] = (!border && glm::dot(p, p) <= 1.0f) ? WATER_DAMPING : 0.0f;
+            }
+        }
+    }
+
+    // p: impact point on the unit disc (x, z), strength: depth of the dent
+    void impact(const glm::vec2& p, float strength)
+    {
+        const float radius = 2.5f;   // cells
+        float cx = (p.x * 0.5f + 0.5f) * (WATER_GRID - 1);
+        float cy = (p.y * 0.5f + 0.5f) * (WATER_GRID - 1);
+        int x0 = std::max(1, (int)(cx - radius)), x1 = std::min(WATER_GRID - 2, (int)(cx + radius) + 1);
+        int y0 = std::max(1, (int)(cy - radius)), y1 = std::min(WATER_GRID - 2, (int)(cy + radius) + 1);
+        for (int y = y0; y <= y1; y++)
+        {
+            for (int x = x0; x <= x1; x++)
+            {
+                float d2 = ((x - cx) * (x - cx) + (y - cy) * (y - cy)) / (radius * radius);
+                if (d2 >= 1.0f) continue;
+                int i = y * WATER_GRID + x;
+                float falloff = 0.5f + 0.5f * std::cos(3.1415926f * std::sqrt(d2));
+                cur[i] -= strength * falloff * (mask[i] > 0.0f ? 1.0f : 0.0f);
+            }
+        }
+        active = true;
+    }
+
+    // advances the simulation; true when the heightfield changed (upload it)
+    bool update(float dt)
+    {
+        if (!active) return false;
+
+        accumulator = std::min(accumulator + dt, WATER_STEP * WATER_MAX_STEPS);
+        bool changed = false;
+        while (accumulator >= WATER_STEP)
+        {
+            accumulator -= WATER_STEP;
+            changed = true;
+            if (step() < WATER_IDLE_EPS)
+            {
+                std::fill(cur.begin(), cur.end(), 0.0f);
+                std::fill(prev.begin(), prev.end(), 0.0f);
+                accumulator = 0.0f;
+                active = false;
+                break;
+            }
+        }
+        return changed;
+    }
+
+    bool idle() const
+    {
+        return !active;
+    }
+
+    void reset()
+    {
+        std::fill(cur.begin(), cur.end(), 0.0f);
+        std::fill(prev.begin(), prev.end(), 0.0f);
+        active = true;   // one more upload of the flat field
+    }
+
+    // WATER_GRID x WATER_GRID, row = z
+    const float* heights() const
+    {
+        return cur.data();
+    }
+
+private:
+    std::vector<float> cur, prev, mask;   // mask: damping inside the disc, 0 outside
+    float accumulator = 0.0f;
+    bool active = false;
+
+    static glm::vec2 cellToDisc(int x, int y)
+    {
+        const float scale = 2.0f / (WATER_GRID - 1);
+        return glm::vec2(x * scale - 1.0f, y * scale - 1.0f);
+    }
+
+    // one wave step, 'prev' becomes the new field; returns the largest |height|
+    float step()
+    {
+        const int n = WATER_GRID;
+        float maxAbs = 0.0f;
+        for (int y = 1; y < n - 1; y++)
+        {
+            const float* c = &cur[y * n];
+            const float* up = c - n;
+            const float* down = c + n;
+            float* p = &prev[y * n];
+            const float* m = &mask[y * n];
+
+            int x = 1;
+#if defined(WATER_SSE)
+            const __m128 half = _mm_set1_ps(0.5f);
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+            __m128 rowMax = _mm_setzero_ps();
+            for (; x + 4 <= n - 1; x += 4)
+            {
+                __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(c + x - 1), _mm_loadu_ps(c + x + 1)),
+                    _mm_add_ps(_mm_loadu_ps(up + x), _mm_loadu_ps(down + x)));
+                __m128 next = _mm_sub_ps(_mm_mul_ps(sum, half), _mm_loadu_ps(p + x));
+                next = _mm_mul_ps(next, _mm_loadu_ps(m + x));
+                _mm_storeu_ps(p + x, next);
+                rowMax = _mm_max_ps(rowMax, _mm_and_ps(next, absMask));
+            }
+            float lanes[4];
+            _mm_storeu_ps(lanes, rowMax);
+            maxAbs = std::max(maxAbs, std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3])));
+#endif
+            for (; x < n - 1; x++)
+            {
+                float next = ((c[x - 1] + c[x + 1] + up[x] + down[x]) * 0.5f - p[x]) * m[x];
+                p[x] = next;
+                maxAbs = std::max(maxAbs, std::fabs(next));
+            }
+        }
+        cur.swap(prev);
+        return maxAbs;
+    }
+};
+
+// Water inside the basin: one static unit mesh shaped entirely in the vertex shader
+// (basic.vert, WATER feature). level, radii and placement are uniforms + the object record,
+// the surface is displaced by the ripple heightfield (R32F texture), so nothing is rebuilt
+// or uploaded per frame unless ripples are moving.
+class WaterSurface {
+public:
+    // unit mesh: xz on the unit disc, y = 0 on the bottom ring and 1 on the surface
+    void init(int segments = 64, int rings = 16)
+    {
+        std::vector<float> v;
+        auto push = [&](float x, float y, float z, const glm::vec3& n) {
+            v.push_back(x); v.push_back(y); v.push_back(z);
+            v.push_back(n.x); v.push_back(n.y); v.push_back(n.z);
+        };
+        const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+        for (int i = 0; i < segments; i++)
+        {
+            float a0 = (float)i / segments * 2.0f * 3.1415926f;
+            float a1 = (float)(i + 1) / segments * 2.0f * 3.1415926f;
+            float c0 = std::cos(a0), s0 = std::sin(a0);
+            float c1 = std::cos(a1), s1 = std::sin(a1);
+
+            // side wall
+            glm::vec3 n0 = glm::normalize(glm::vec3(c0, 0.2f, s0));
+            glm::vec3 n1 = glm::normalize(glm::vec3(c1, 0.2f, s1));
+            push(c0, 1.0f, s0, n0); push(c0, 0.0f, s0, n0); push(c1, 0.0f, s1, n1);
+            push(c0, 1.0f, s0, n0); push(c1, 0.0f, s1, n1); push(c1, 1.0f, s1, n1);
+
+            // surface: a fan around the center, then quads out to the rim so ripples have vertices
+            float r = 1.0f / rings;
+            push(0.0f, 1.0f, 0.0f, up); push(c0 * r, 1.0f, s0 * r, up); push(c1 * r, 1.0f, s1 * r, up);
+            for (int k = 1; k < rings; k++)
+            {
+                float ri = (float)k / rings, ro = (float)(k + 1) / rings;
+                push(c0 * ri, 1.0f, s0 * ri, up); push(c0 * ro, 1.0f, s0 * ro, up); push(c1 * ro, 1.0f, s1 * ro, up);
+                push(c0 * ri, 1.0f, s0 * ri, up); push(c1 * ro, 1.0f, s1 * ro, up); push(c1 * ri, 1.0f, s1 * ri, up);
+            }
+        }
+        vertexCount = (int)v.size() / 6;
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, v.size() * sizeof(float), v.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+
+        glGenTextures(1, &rippleTex);
+        glBindTexture(GL_TEXTURE_2D, rippleTex);
+        const std::vector<float> flat(WATER_GRID * WATER_GRID, 0.0f);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, WATER_GRID, WATER_GRID, 0, GL_RED, GL_FLOAT, flat.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // new ripple heightfield (WaterRipples::heights()); the ripples themselves are stepped by
+    // whoever owns them, possibly on another thread, so only call this when they changed
+    void upload(const float* heights)
+    {
+        glBindTexture(GL_TEXTURE_2D, rippleTex);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, WATER_GRID, WATER_GRID, GL_RED, GL_FLOAT, heights);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // per frame, while recording. center: basin axis (x, z) at world y = 0;
+    // radii and heights of the water body in world units. empty when yTop <= yBottom
+    void submit(ObjectBuffer& objects, FrustumCuller& culler, const glm::vec3& center,
+        float rBottom, float rTop, float yBottom, float yTop, const glm::vec3& color)
+    {
+        object = -1;
+        if (yTop <= yBottom) return;
+        shape = glm::vec4(rBottom, rTop, yBottom, yTop);
+
+        glm::mat4 M(1.0f);
+        M[3] = glm::vec4(center.x, 0.0f, center.z, 1.0f);
+        object = objects.push(M, color);
+
+        float r = std::max(rBottom, rTop);
+        bounds = culler.add(M, glm::vec3(-r, yBottom, -r), glm::vec3(r, yTop + WATER_RIPPLE_HEIGHT, r));
+    }
+
+    // nothing this frame (e.g. the basin is out of view)
+    void hide()
+    {
+        object = -1;
+    }
+
+    // expects the object buffer uploaded + bound; 'feature' selects the WATER variant
+    void draw(ShaderVariants& shaders, unsigned int feature, UniformKey objectIndex, const FrustumCuller& culler)
+    {
+        if (object < 0 || !culler.visible(bounds)) return;
+
+        Shader& shader = shaders.get(feature);
+        shader.use();
+        shader.setInt(objectIndex, object);
+        shader.setVec4(U_WATER_SHAPE, shape);
+        shader.setFloat(U_RIPPLE_SCALE, WATER_RIPPLE_HEIGHT);
+        shader.setInt(U_RIPPLES, (int)WATER_RIPPLE_UNIT);
+
+        glActiveTexture(GL_TEXTURE0 + WATER_RIPPLE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, rippleTex);
+        glActiveTexture(GL_TEXTURE0);
+
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        glBindVertexArray(0);
+    }
+
+private:
+    // hashed at compile time
+    static constexpr UniformKey U_WATER_SHAPE{ "uWaterShape" };
+    static constexpr UniformKey U_RIPPLE_SCALE{ "uRippleScale" };
+    static constexpr UniformKey U_RIPPLES{ "uRipples" };
+
+    unsigned int VAO = 0, VBO = 0;
+    int vertexCount = 0;
+    unsigned int rippleTex = 0;
+
+    glm::vec4 shape = glm::vec4(0.0f);   // rBottom, rTop, yBottom, yTop
+    int object = -1;
+    int bounds = -1;
+};
+
+#endif